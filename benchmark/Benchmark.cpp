@@ -0,0 +1,474 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Automaton.hpp"
+#include "FileScanner.hpp"
+#include "LazyDfa.hpp"
+#include "PatternSet.hpp"
+#include "SearchAutomaton.hpp"
+#include "StaticRegex.hpp"
+#include "StreamMatcher.hpp"
+
+/** Benchmarks of the regex and automaton pipeline.
+ *
+ *  Usage: automaton_benchmark [filter] [--min-time seconds]
+ *
+ *  Every benchmark whose name contains the filter is run repeatedly until it took at least the
+ *  minimum time, and the time of one iteration is printed, with the throughput for the ones
+ *  that scan text. The inputs are generated with a fixed seed, so runs are comparable.
+ *
+ */
+
+namespace {
+    std::string filter;
+    double minTime = 0.5;
+
+    ///Keeps the compiler from dropping the benchmarked work.
+    volatile std::size_t sink = 0;
+
+    /** Runs the function until it took at least minTime and prints the time of one call.
+     *
+     *  If bytes is not 0 it is the size of the input processed by one call and the throughput
+     *  is printed too.
+     *
+     */
+    void run(const std::string& name, std::size_t bytes, const std::function<std::size_t()>& function) {
+        if (name.find(filter) == std::string::npos) return;
+
+        using Clock = std::chrono::steady_clock;
+        std::size_t iterations = 1;
+        double seconds = 0;
+        while (true) {
+            Clock::time_point start = Clock::now();
+            for (std::size_t i = 0; i < iterations; i++) {
+                sink = sink + function();
+            }
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (seconds >= minTime || iterations >= (1u << 30)) break;
+
+            //Aim a bit over the minimum time so that the next round is usually the last one.
+            double scale = seconds > 0 ? minTime * 1.4 / seconds : 100;
+            iterations = std::max(iterations + 1, (std::size_t) (iterations * std::min(scale, 100.0)));
+        }
+
+        double perIteration = seconds / iterations;
+        const char* unit = "s";
+        double shown = perIteration;
+        if (perIteration < 1e-6) { shown = perIteration * 1e9; unit = "ns"; }
+        else if (perIteration < 1e-3) { shown = perIteration * 1e6; unit = "us"; }
+        else if (perIteration < 1) { shown = perIteration * 1e3; unit = "ms"; }
+
+        std::printf("%-48s %12zu %10.2f %-2s", name.c_str(), iterations, shown, unit);
+        if (bytes != 0) std::printf(" %10.1f MB/s", bytes / perIteration / 1e6);
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    std::string randomWord(std::mt19937& generator, std::size_t minLength, std::size_t maxLength, char lastLetter = 'z') {
+        std::uniform_int_distribution<std::size_t> length(minLength, maxLength);
+        std::uniform_int_distribution<int> letter('a', lastLetter);
+
+        std::string word(length(generator), 'a');
+        for (char& c : word) {
+            c = (char) letter(generator);
+        }
+        return word;
+    }
+
+    ///Union of count random words, the usual shape of a dictionary filter.
+    std::string alternation(std::size_t count, unsigned seed = 1) {
+        std::mt19937 generator(seed);
+        std::string regex;
+        for (std::size_t i = 0; i < count; i++) {
+            if (i != 0) regex += '+';
+
+            std::string word = randomWord(generator, 4, 10);
+            for (std::size_t j = 0; j < word.size(); j++) {
+                if (j != 0) regex += '.';
+                regex += word[j];
+            }
+        }
+        return regex;
+    }
+
+    ///Expression nested depth times: ((((a.b)*+c).b)*+c)...
+    std::string nested(std::size_t depth) {
+        std::string regex = "a";
+        for (std::size_t i = 0; i < depth; i++) {
+            regex = "((" + regex + ".b)*+c)";
+        }
+        return regex;
+    }
+
+    /** (a+b)*.a.(a+b)...(a+b) with k copies of (a+b) at the end.
+     *
+     *  The deterministic automaton has to remember the last k + 1 letters, so it has 2^(k+1)
+     *  states while the nondeterministic one has O(k).
+     *
+     */
+    std::string blowup(std::size_t k) {
+        std::string regex = "(a+b)*.a";
+        for (std::size_t i = 0; i < k; i++) {
+            regex += ".(a+b)";
+        }
+        return regex;
+    }
+
+    Automaton fromRegex(const std::string& regex) {
+        Automaton automaton;
+        automaton.readRegex(regex);
+        return automaton;
+    }
+
+    ///Random words separated by spaces and newlines, about size bytes.
+    std::string corpus(std::size_t size, unsigned seed = 2) {
+        std::mt19937 generator(seed);
+        std::string text;
+        text.reserve(size + 16);
+        while (text.size() < size) {
+            text += randomWord(generator, 3, 12);
+            text += generator() % 8 == 0 ? '\n' : ' ';
+        }
+        return text;
+    }
+
+    std::vector<std::string_view> records(std::string_view text, FileScanner::RecordMode mode) {
+        std::vector<std::string_view> result;
+        FileScanner::forEachRecord(text, mode, [&](std::string_view record) {
+            result.push_back(record);
+        });
+        return result;
+    }
+
+    void frontEnd() {
+        for (std::size_t count : {10, 100, 1000, 10000}) {
+            std::string regex = alternation(count);
+            run("readRegex/alternation/" + std::to_string(count), 0, [&]() {
+                return fromRegex(regex).getStates().size();
+            });
+        }
+        for (std::size_t depth : {10, 100, 1000}) {
+            std::string regex = nested(depth);
+            run("readRegex/nested/" + std::to_string(depth), 0, [&]() {
+                return fromRegex(regex).getStates().size();
+            });
+        }
+    }
+
+    void determinization() {
+        for (std::size_t count : {10, 100, 1000}) {
+            Automaton automaton = fromRegex(alternation(count));
+            std::string suffix = "/alternation/" + std::to_string(count);
+
+            run("determine" + suffix, 0, [&]() {
+                Automaton copy = automaton;
+                copy.determine();
+                return copy.getStates().size();
+            });
+            run("minimize" + suffix, 0, [&]() {
+                Automaton copy = automaton;
+                copy.minimize();
+                return copy.getStates().size();
+            });
+            run("compile" + suffix, 0, [&]() {
+                return automaton.compile().stateCount();
+            });
+            run("compile-minimized" + suffix, 0, [&]() {
+                return automaton.compile(true).stateCount();
+            });
+        }
+
+        //Pathological patterns: exponential deterministic automata.
+        for (std::size_t k : {4, 8, 12, 16}) {
+            Automaton automaton = fromRegex(blowup(k));
+            run("compile/blowup/" + std::to_string(k), 0, [&]() {
+                return automaton.compile().stateCount();
+            });
+        }
+        for (std::size_t k : {4, 8, 12}) {
+            Automaton automaton = fromRegex(blowup(k));
+            run("compile-minimized/blowup/" + std::to_string(k), 0, [&]() {
+                return automaton.compile(true).stateCount();
+            });
+        }
+
+        for (std::size_t count : {100, 2000}) {
+            PatternSet patterns;
+            for (std::size_t i = 0; i < count; i++) {
+                patterns.add(alternation(1, i + 1));
+            }
+            run("PatternSet::compile/" + std::to_string(count) + " patterns", 0, [&]() {
+                return patterns.compile().stateCount();
+            });
+        }
+    }
+
+    void operations() {
+        for (std::size_t count : {10, 100, 1000}) {
+            Automaton first = fromRegex(alternation(count, 1));
+            Automaton second = fromRegex(alternation(count, 2));
+            Automaton containsE = fromRegex("?*.e.?*");
+            std::string suffix = "/" + std::to_string(count);
+
+            run("un" + suffix, 0, [&]() {
+                return Automaton::un(first, second).getStates().size();
+            });
+            run("concat" + suffix, 0, [&]() {
+                return Automaton::concat(first, second).getStates().size();
+            });
+            run("intersection" + suffix, 0, [&]() {
+                return Automaton::intersection(first, containsE).getStates().size();
+            });
+            run("complement" + suffix, 0, [&]() {
+                return Automaton::complement(first).getStates().size();
+            });
+            //Both operands are large here, the product grows with the square of the size.
+            if (count > 100) continue;
+            run("intersection-product" + suffix, 0, [&]() {
+                return Automaton::intersection(first, first).getStates().size();
+            });
+        }
+    }
+
+    void regexOutput() {
+        for (std::size_t k : {1, 2, 3, 4}) {
+            Automaton automaton = fromRegex(blowup(k));
+            automaton.minimize();
+            run("convertToRegex/blowup/" + std::to_string(k) + " (" + std::to_string(automaton.getStates().size()) + " states)", 0, [&]() {
+                return automaton.convertToRegex().size();
+            });
+        }
+        //Without minimize() the states of the nondeterministic automaton are eliminated as they are.
+        for (std::size_t k : {4, 5, 8, 16, 64}) {
+            Automaton automaton = fromRegex(blowup(k));
+            run("convertToRegex/blowup NFA/" + std::to_string(k) + " (" + std::to_string(automaton.getStates().size()) + " states)", 0, [&]() {
+                return automaton.convertToRegex().size();
+            });
+        }
+        for (std::size_t count : {10, 100}) {
+            Automaton automaton = fromRegex(alternation(count));
+            automaton.minimize();
+            run("convertToRegex/alternation/" + std::to_string(count) + " (" + std::to_string(automaton.getStates().size()) + " states)", 0, [&]() {
+                return automaton.convertToRegex().size();
+            });
+        }
+    }
+
+    void matching() {
+        std::string text = corpus(4 << 20);
+        std::vector<std::string_view> words = records(text, FileScanner::words);
+
+        Automaton dictionary = fromRegex(alternation(1000));
+        Automaton pattern = fromRegex("(a+b+c)*.?*.(x+y+z)");
+        CompiledAutomaton compiledDictionary = dictionary.compile(true);
+        CompiledAutomaton compiledPattern = pattern.compile(true);
+
+        auto matchAll = [&](auto& matcher, const std::vector<std::string_view>& input) {
+            std::size_t matches = 0;
+            for (std::string_view word : input) {
+                matches += matcher.match(word);
+            }
+            return matches;
+        };
+
+        //The NFA simulation is much slower, it gets a smaller part of the corpus.
+        std::vector<std::string_view> someWords(words.begin(), words.begin() + words.size() / 16);
+        std::size_t someBytes = someWords.back().data() + someWords.back().size() - text.data();
+        run("recognize/pattern", someBytes, [&]() {
+            std::size_t matches = 0;
+            for (std::string_view word : someWords) {
+                matches += pattern.recognize(std::string(word));
+            }
+            return matches;
+        });
+
+        run("CompiledAutomaton::match/dictionary", text.size(), [&]() {
+            return matchAll(compiledDictionary, words);
+        });
+        run("CompiledAutomaton::match/pattern", text.size(), [&]() {
+            return matchAll(compiledPattern, words);
+        });
+
+        //An exclusion filter, most words reach the accepting sink after a few letters.
+        CompiledAutomaton compiledExclusion = dictionary.compileComplement(true);
+        run("CompiledAutomaton::match/complement of dictionary", text.size(), [&]() {
+            return matchAll(compiledExclusion, words);
+        });
+
+        run("CompiledAutomaton::matchBatch/dictionary", text.size(), [&]() {
+            std::size_t matches = 0;
+            for (std::uint64_t bits : compiledDictionary.matchBatch(words)) {
+                matches += __builtin_popcountll(bits);
+            }
+            return matches;
+        });
+
+        static constexpr auto staticPattern = StaticRegex::compile("(a+b+c)*.?*.(x+y+z)");
+        run("StaticAutomaton::match/pattern", text.size(), [&]() {
+            return matchAll(staticPattern, words);
+        });
+
+        LazyDfa lazyDictionary(dictionary);
+        run("LazyDfa::match/dictionary", text.size(), [&]() {
+            return matchAll(lazyDictionary, words);
+        });
+
+        PatternSet patterns;
+        for (std::size_t i = 0; i < 100; i++) {
+            patterns.add(alternation(10, i + 10));
+        }
+        CompiledAutomaton compiledPatterns = patterns.compile(true);
+        run("CompiledAutomaton::matchPatterns/100 patterns", text.size(), [&]() {
+            std::size_t matches = 0;
+            for (std::string_view word : words) {
+                matches += compiledPatterns.matchPatterns(word).size();
+            }
+            return matches;
+        });
+
+        //Pathological input for a lazy automaton: every letter reaches a new state.
+        std::mt19937 generator(3);
+        std::string abText;
+        for (std::size_t i = 0; i < (1 << 20) / 32; i++) {
+            abText += randomWord(generator, 32, 32, 'b');
+            abText += ' ';
+        }
+        std::vector<std::string_view> abWords = records(abText, FileScanner::words);
+        //Long words on a table of 2^17 states, most table loads miss the cache.
+        CompiledAutomaton compiledBlowup = fromRegex(blowup(16)).compile();
+        std::string longText;
+        for (std::size_t i = 0; i < (4 << 20) / 64; i++) {
+            longText += randomWord(generator, 63, 63, 'b');
+            longText += ' ';
+        }
+        std::vector<std::string_view> longWords = records(longText, FileScanner::words);
+        run("CompiledAutomaton::match/blowup/16", longText.size(), [&]() {
+            return matchAll(compiledBlowup, longWords);
+        });
+        run("CompiledAutomaton::matchBatch/blowup/16", longText.size(), [&]() {
+            std::size_t matches = 0;
+            for (std::uint64_t bits : compiledBlowup.matchBatch(longWords)) {
+                matches += __builtin_popcountll(bits);
+            }
+            return matches;
+        });
+
+        Automaton blowupAutomaton = fromRegex(blowup(20));
+        LazyDfa lazyBlowup(blowupAutomaton, 1 << 20);
+        run("LazyDfa::match/blowup/20 (1 MiB cache)", abText.size(), [&]() {
+            return matchAll(lazyBlowup, abWords);
+        });
+
+        //The corpus arrives in chunks that split records, like reads from a pipe.
+        for (FileScanner::RecordMode mode : {FileScanner::words, FileScanner::lines}) {
+            std::string modeName = mode == FileScanner::words ? "words" : "lines";
+            StreamMatcher stream(compiledDictionary, mode);
+            run("StreamMatcher/" + modeName + "/dictionary/64 KiB chunks", text.size(), [&]() {
+                std::size_t matches = 0;
+                auto count = [&](StreamMatcher::Record) { matches++; };
+                for (std::size_t start = 0; start < text.size(); start += 64 << 10) {
+                    stream.feedRecords(text.data() + start, std::min<std::size_t>(64 << 10, text.size() - start), count);
+                }
+                stream.finishRecords(count);
+                return matches;
+            });
+        }
+    }
+
+    void search() {
+        std::string text = corpus(16 << 20);
+
+        SearchAutomaton absent(fromRegex("x.y.z.z.y"), true);
+        SearchAutomaton rare(fromRegex("q.u.(a+e+i+o+u)*.z"), true);
+        SearchAutomaton frequent(fromRegex("(t+s).h.(a+e+i+o+u)*"), true);
+
+        run("SearchAutomaton::contains/absent", text.size(), [&]() {
+            return (std::size_t) absent.contains(text);
+        });
+        run("SearchAutomaton::findAll/absent", text.size(), [&]() {
+            return absent.findAll(text).size();
+        });
+        run("SearchAutomaton::findAll/rare", text.size(), [&]() {
+            return rare.findAll(text).size();
+        });
+        run("SearchAutomaton::findAll/frequent", text.size(), [&]() {
+            return frequent.findAll(text).size();
+        });
+
+        //Every 'a' is a match and every extension could go on to the end of the text.
+        std::string runOfA(64 << 10, 'a');
+        SearchAutomaton unbounded(fromRegex("a+a.?*.c"), true);
+        run("SearchAutomaton::findAll/unbounded extensions", runOfA.size(), [&]() {
+            return unbounded.findAll(runOfA).size();
+        });
+    }
+
+    void fileScan() {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "automaton_benchmark_corpus.txt";
+        std::string text = corpus(32 << 20);
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << text;
+        }
+
+        CompiledAutomaton dictionary = fromRegex(alternation(1000)).compile(true);
+        CompiledAutomaton prefixed = fromRegex("q.u.(a+e+i+o+u)*.?*").compile(true);
+
+        for (FileScanner::RecordMode mode : {FileScanner::words, FileScanner::lines}) {
+            std::string modeName = mode == FileScanner::words ? "words" : "lines";
+            run("FileScanner/" + modeName + "/dictionary", text.size(), [&]() {
+                FileScanner scanner(path.string());
+                std::size_t matches = 0;
+                scanner.forEachRecord(mode, [&](std::string_view record) {
+                    matches += dictionary.match(record);
+                });
+                return matches;
+            });
+        }
+
+        run("FileScanner/words/required prefix", text.size(), [&]() {
+            FileScanner scanner(path.string());
+            std::size_t matches = 0;
+            FileScanner::forEachRecordWithPrefix(scanner.getContents(), FileScanner::words, prefixed.getRequiredPrefix(), [&](std::string_view record) {
+                matches += prefixed.match(record);
+            });
+            return matches;
+        });
+
+        std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        run("FileScanner/words/dictionary/" + std::to_string(threads) + " threads", text.size(), [&]() {
+            FileScanner scanner(path.string());
+            return scanner.findMatches(FileScanner::words, dictionary, threads).size();
+        });
+
+        std::filesystem::remove(path);
+    }
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--min-time" && i + 1 < argc) minTime = std::stod(argv[++i]);
+        else filter = argument;
+    }
+
+    std::printf("%-48s %12s %13s %15s\n", "Benchmark", "Iterations", "Time", "Throughput");
+
+    frontEnd();
+    determinization();
+    operations();
+    regexOutput();
+    matching();
+    search();
+    fileScan();
+
+    return 0;
+}
@@ -1,121 +1,174 @@
 #include "Automaton.hpp"
-#include <stack>
-#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
 #include "RegexUtils.hpp"
+#include "Tokenizer.hpp"
+#include "NfaSimulator.hpp"
 
-void Automaton::copy(const Automaton& other) {
-    if (this != &other) {
-        states = other.states;
-        beginningStates = other.beginningStates;
-        finalStates = other.finalStates;
+const CompactNfa& Automaton::data() const {
+    return *getCompactNfa();
+}
 
-        transitions = other.transitions;
-        neighbours = other.neighbours;
-    }
+CompactNfa::LabelRange Automaton::getStates() const {
+    return data().getStateLabels();
 }
 
-void Automaton::updateNeighbours() {
-    this -> neighbours.clear();
+CompactNfa::LabelRange Automaton::getBeginningStates() const {
+    return data().getBeginningLabels();
+}
 
-    for (int state : states) {
-        neighbours[state];
-    }
+CompactNfa::LabelRange Automaton::getFinalStates() const {
+    return data().getFinalLabels();
+}
 
-    for (auto t : transitions) {
-        neighbours.at(t.first.first).insert(t.first.second);
-    }
+CompactNfa::TransitionRange Automaton::getTransitions() const {
+    return data().getTransitions();
 }
 
-Automaton::Automaton(const Automaton& other) {
-    copy(other);
+std::map<int, std::set<int>> Automaton::getNeighbours() const {
+    std::map<int, std::set<int>> neighbours;
+    for (int state : getStates()) {
+        neighbours.emplace_hint(neighbours.end(), state, std::set<int>());
+    }
+    for (auto& transition : getTransitions()) {
+        std::set<int>& stateNeighbours = neighbours[transition.first.first];
+        stateNeighbours.insert(stateNeighbours.end(), transition.first.second);
+    }
+    return neighbours;
 }
 
+std::shared_ptr<const CompactNfa> Automaton::getCompactNfa() const {
+    static const std::shared_ptr<const CompactNfa> empty = std::make_shared<const CompactNfa>();
+    return nfa ? nfa : empty;
+}
 
-std::set<int> Automaton::getStates() const {
-    return this -> states;
+void Automaton::setStates(const std::set<int>& other) {
+    Builder builder(*this);
+    builder.states.assign(other.begin(), other.end());
+    *this = builder.finalize();
 }
 
-std::set<int> Automaton::getBeginningStates() const {
-    return this -> beginningStates;
+void Automaton::setBeginningStates(const std::set<int>& other) {
+    Builder builder(*this);
+    builder.beginningStates.assign(other.begin(), other.end());
+    *this = builder.finalize();
 }
 
-std::set<int> Automaton::getFinalStates() const {
-    return this -> finalStates;
+void Automaton::setFinalStates(const std::set<int>& other) {
+    Builder builder(*this);
+    builder.finalStates.assign(other.begin(), other.end());
+    *this = builder.finalize();
 }
 
-Automaton::Transitions Automaton::getTransitions() const {
-    return this -> transitions;
+void Automaton::setTransitions(const Transitions& other) {
+    Builder builder(*this);
+    builder.transitions.clear();
+    for (auto& transition : other) {
+        for (char letter : transition.second) {
+            builder.addTransition(transition.first, letter);
+        }
+    }
+    *this = builder.finalize();
 }
 
-std::map<int, std::set<int>> Automaton::getNeighbours() const {
-    return this -> neighbours;
+void Automaton::addState(const int state, bool beginning, bool final) {
+    Builder builder(*this);
+    builder.addState(state, beginning, final);
+    *this = builder.finalize();
 }
 
-void Automaton::setStates(std::set<int> other) {
-    this -> states = other;
+void Automaton::addBeginningState(const int state) {
+    addState(state, true);
 }
 
-void Automaton::setBeginningStates(std::set<int> other) {
-    this -> beginningStates = other;
+void Automaton::addFinalState(const int state) {
+    addState(state, false, true);
 }
 
-void Automaton::setFinalStates(std::set<int> other) {
-    this -> finalStates = other;
+void Automaton::addTransition(Edge edge, const TransitionLetters& letters) {
+    Builder builder(*this);
+    for (char letter : letters) {
+        builder.addTransition(edge, letter);
+    }
+    *this = builder.finalize();
 }
 
-void Automaton::setTransitions(Transitions other) {
-    this -> transitions = other;
+Automaton::Builder::Builder(const Automaton& automaton) {
+    addAutomaton(automaton, 0, true, true);
 }
 
-void Automaton::addState(const int state, bool beginning = false, bool final = false) {
-    states.insert(state);
-    if (beginning) {
-        beginningStates.insert(state);
-    }
-    if (final) {
-        finalStates.insert(state);
-    }
+void Automaton::Builder::reserve(std::size_t stateCount, std::size_t transitionCount) {
+    states.reserve(stateCount);
+    transitions.reserve(transitionCount);
+}
 
-    updateNeighbours();
+void Automaton::Builder::addState(int state, bool beginning, bool final) {
+    states.push_back(state);
+    if (beginning) beginningStates.push_back(state);
+    if (final) finalStates.push_back(state);
 }
 
-void Automaton::addBeginningState(const int state) {
-    addState(state, true);
+void Automaton::Builder::addTransition(Edge edge, char letter) {
+    transitions.push_back(std::make_pair(edge, letter));
 }
 
-void Automaton::addFinalState(const int state) {
-    addState(state, false, true);
+void Automaton::Builder::addTransitions(const std::vector<std::pair<Edge, char>>& batch) {
+    transitions.insert(transitions.end(), batch.begin(), batch.end());
 }
 
-void Automaton::addTransition(Edge edge, TransitionLetters letters) {
-    for (char c : letters) {
-        transitions[edge].insert(c);
+void Automaton::Builder::addAutomaton(const Automaton& automaton, int offset, bool beginning, bool final) {
+    for (int state : automaton.getStates()) {
+        states.push_back(state + offset);
+    }
+    if (beginning) {
+        for (int state : automaton.getBeginningStates()) {
+            beginningStates.push_back(state + offset);
+        }
+    }
+    if (final) {
+        for (int state : automaton.getFinalStates()) {
+            finalStates.push_back(state + offset);
+        }
+    }
+    for (auto& transition : automaton.getTransitions()) {
+        Edge edge = std::make_pair(transition.first.first + offset, transition.first.second + offset);
+        for (char letter : transition.second) {
+            transitions.push_back(std::make_pair(edge, letter));
+        }
     }
+}
 
-    addState(edge.first);
-    addState(edge.second);
+Automaton Automaton::Builder::finalize() {
+    Automaton automaton;
+    automaton.nfa = std::make_shared<const CompactNfa>(std::move(states), std::move(beginningStates), std::move(finalStates), std::move(transitions));
 
-    updateNeighbours();
+    states.clear();
+    beginningStates.clear();
+    finalStates.clear();
+    transitions.clear();
+    return automaton;
 }
 
 void Automaton::printInfo() const {
     std::cout << "States: ";
-    for (int state : states) {
+    for (int state : getStates()) {
         std::cout << state << " ";
     }
 
     std::cout << "\nBeginning states: ";
-    for (int beginningState : beginningStates) {
+    for (int beginningState : getBeginningStates()) {
         std::cout << beginningState << " ";
     }
 
     std::cout << "\nFinal states: ";
-    for (int finalState : finalStates) {
+    for (int finalState : getFinalStates()) {
         std::cout << finalState << " ";
     }
 
     std::cout << "\nTransitions:\n";
-    for (auto transition : transitions) {
+    for (auto& transition : getTransitions()) {
         printf("From %d to %d -> ", transition.first.first, transition.first.second);
         for (char letter : transition.second) {
             std::cout << letter << " ";
@@ -125,308 +178,225 @@ void Automaton::printInfo() const {
 }
 
 bool Automaton::recognize(const std::string& str) const {
-    Automaton automatonToWorkWith = *this;
-    automatonToWorkWith.determine();
-    for (int beginningState: automatonToWorkWith.beginningStates) {
-            std::string currentWord = ""; 
-            std::vector<int> path;
-
-            std::stack<Edge> dfsStack;
-
-            int current = beginningState;
-
-            dfsStack.push({current, current});
-
-            while(!dfsStack.empty())
-            {
-                Edge top = dfsStack.top();
-                dfsStack.pop();
-
-                while(!path.empty() && path[path.size()-1] != top.first) {
-                    path.pop_back();
-                    if (automatonToWorkWith.transitions.count(top) > 0 && automatonToWorkWith.transitions.at(top).count(EPSILON) == 0) {
-                        currentWord.pop_back();
-                    }
-                }
-
-                path.push_back(top.second);
-                if (automatonToWorkWith.transitions.count(top) > 0 && automatonToWorkWith.transitions.at(top).count(EPSILON) == 0) {
-                    currentWord.push_back(str[currentWord.size()]);
-                }
+    return NfaSimulator(*this).match(str);
+}
 
-                if (currentWord == str && automatonToWorkWith.finalStates.count(top.second) > 0) return true;
+CompiledAutomaton Automaton::compile(bool minimized) const {
+    CompactNfa::DeterministicTable dfa = getCompactNfa() -> determine();
+    if (minimized) {
+        dfa.minimize();
+    }
+    return CompiledAutomaton(dfa);
+}
 
-                for (int vert : automatonToWorkWith.neighbours.at(top.second)) { 
-                    if (automatonToWorkWith.transitions.at(std::make_pair(top.second, vert)).count(str[currentWord.size()]) > 0 
-                        || automatonToWorkWith.transitions.at(std::make_pair(top.second, vert)).count(EPSILON) > 0 
-                        || automatonToWorkWith.transitions.at(std::make_pair(top.second, vert)).count('?') > 0) {
+CompiledAutomaton Automaton::compileComplement(bool minimized) const {
+    std::array<bool, 256> alphabet;
+    alphabet.fill(true);
 
-                        dfsStack.push(std::make_pair(top.second, vert));
-                    
-                    }
-                }
-            }
+    CompactNfa::DeterministicTable dfa = getCompactNfa() -> determine();
+    dfa.complement(alphabet);
+    if (minimized) {
+        dfa.minimize();
     }
-    return false;
+    return CompiledAutomaton(dfa);
 }
 
 Automaton Automaton::un(const Automaton& first, const Automaton& second) {
-    Automaton newAutomaton = first;
-    
-    int firstLastState = *(--newAutomaton.getStates().end());
-
-    for(int secondState : second.getStates()) {
-        newAutomaton.addState(secondState + firstLastState);
-        if (second.beginningStates.count(secondState) != 0) newAutomaton.addBeginningState(secondState + firstLastState);
-        if (second.finalStates.count(secondState) != 0) newAutomaton.addFinalState(secondState + firstLastState);
-    }
-
-    for (auto it : second.getTransitions()) {
-        newAutomaton.addTransition(std::make_pair(it.first.first + firstLastState, it.first.second + firstLastState), it.second);
-    }
+    int firstLastState = *first.getStates().rbegin();
 
-    int newState = *(--newAutomaton.getStates().end()) + 1;
+    Builder builder;
+    builder.addAutomaton(first, 0, false, true);
+    builder.addAutomaton(second, firstLastState, false, true);
 
-    newAutomaton.addState(newState);
+    int newState = *second.getStates().rbegin() + firstLastState + 1;
+    builder.addState(newState, true);
 
-    for(int begState : newAutomaton.getBeginningStates()) {
-        newAutomaton.addTransition(std::make_pair(newState, begState), {EPSILON});
+    for (int beginningState : first.getBeginningStates()) {
+        builder.addTransition(std::make_pair(newState, beginningState), EPSILON);
     }
-
-    newAutomaton.setBeginningStates(std::set<int>());
-    newAutomaton.addBeginningState(newState);
-
-    return newAutomaton;
-}
-
-Automaton::TransitionLetters Automaton::getCommonLetters (const TransitionLetters first, const TransitionLetters second) {
-    TransitionLetters common;
-    for (char firstTransition : first) {
-        if (second.count(firstTransition) > 0) common.insert(firstTransition);
+    for (int beginningState : second.getBeginningStates()) {
+        builder.addTransition(std::make_pair(newState, beginningState + firstLastState), EPSILON);
     }
-    return common;
+
+    return builder.finalize();
 }
 
 Automaton Automaton::intersection(const Automaton& first, const Automaton& second) {
-    std::set<std::pair<int, int>> newStates;
-    for (int first : first.states) {
-        for (int second : second.states) {
-            newStates.insert(std::make_pair(first,second));
+    std::shared_ptr<const CompactNfa> firstSnapshot = first.getCompactNfa(), secondSnapshot = second.getCompactNfa();
+    const CompactNfa& firstNfa = *firstSnapshot;
+    const CompactNfa& secondNfa = *secondSnapshot;
+
+    //Pairs of states are numbered from 1 in the order they are reached.
+    std::unordered_map<long long, int> ids;
+    std::vector<std::pair<int, int>> pairs;
+    auto getId = [&](int firstState, int secondState) {
+        long long key = (long long) firstState * secondNfa.stateCount() + secondState;
+        auto inserted = ids.emplace(key, pairs.size() + 1);
+        if (inserted.second) pairs.push_back(std::make_pair(firstState, secondState));
+        return inserted.first -> second;
+    };
+
+    Builder builder;
+    for (int firstBeginning : firstNfa.getBeginningStates()) {
+        for (int secondBeginning : secondNfa.getBeginningStates()) {
+            builder.beginningStates.push_back(getId(firstBeginning, secondBeginning));
         }
     }
 
-    Automaton newAutomaton;
-    int stateN1 = 0, stateN2 = 0; 
-    for (std::pair<int, int> firstState : newStates) {
-        stateN1++;
-        if (first.beginningStates.count(firstState.first) > 0 && second.beginningStates.count(firstState.second) > 0) {
-            newAutomaton.addBeginningState(stateN1);
+    for (std::size_t i = 0; i < pairs.size(); i++) {
+        int id = i + 1;
+        int firstState = pairs[i].first, secondState = pairs[i].second;
+
+        builder.addState(id, false, firstNfa.isFinal(firstState) && secondNfa.isFinal(secondState));
+
+        //Epsilon transitions move one of the automatons while the other one waits.
+        for (int to : firstNfa.getEpsilonEdges(firstState)) {
+            builder.addTransition(std::make_pair(id, getId(to, secondState)), EPSILON);
         }
-        if (first.finalStates.count(firstState.first) > 0 && second.finalStates.count(firstState.second) > 0) {
-            newAutomaton.addFinalState(stateN1);
+        for (int to : secondNfa.getEpsilonEdges(secondState)) {
+            builder.addTransition(std::make_pair(id, getId(firstState, to)), EPSILON);
         }
-        for (std::pair<int, int> secondState : newStates ) {
-            stateN2++;
-            if (firstState != secondState) {
-                TransitionLetters commonLetters = getCommonLetters(first.transitions.at(std::make_pair(firstState.first, secondState.first)), second.transitions.at(std::make_pair(firstState.second, secondState.second)));
-                if (commonLetters.size() > 0) {
-                    newAutomaton.addTransition(std::make_pair(stateN1, stateN2), commonLetters);
+
+        //The common letters of two edges are the intersection of their masks. Only two '?' edges
+        //share the letters neither automaton mentions, so only then the result reads '?'.
+        for (std::size_t firstEdge = firstNfa.letterEdgesBegin(firstState); firstEdge < firstNfa.letterEdgesEnd(firstState); firstEdge++) {
+            const std::uint32_t* firstMask = firstNfa.getEdgeMask(firstEdge);
+
+            for (std::size_t secondEdge = secondNfa.letterEdgesBegin(secondState); secondEdge < secondNfa.letterEdgesEnd(secondState); secondEdge++) {
+                const std::uint32_t* secondMask = secondNfa.getEdgeMask(secondEdge);
+
+                std::uint32_t common[CompactNfa::MASK_WORDS];
+                bool empty = true, full = true;
+                for (std::size_t word = 0; word < CompactNfa::MASK_WORDS; word++) {
+                    common[word] = firstMask[word] & secondMask[word];
+                    empty = empty && common[word] == 0;
+                    full = full && common[word] == UINT32_MAX;
+                }
+                if (empty) continue;
+
+                Edge edge = std::make_pair(id, getId(firstNfa.getEdgeTarget(firstEdge), secondNfa.getEdgeTarget(secondEdge)));
+                if (full) {
+                    builder.addTransition(edge, '?');
+                    continue;
+                }
+                for (int byte = 0; byte < 256; byte++) {
+                    if (CompactNfa::maskContains(common, (char) byte)) builder.addTransition(edge, (char) byte);
                 }
             }
         }
-        stateN2 = 0;
     }
-    
-    return newAutomaton;
+
+    return builder.finalize();
 }
 
 Automaton Automaton::concat(const Automaton& first, const Automaton& second) {
-    Automaton newAutomaton;
-    newAutomaton.setStates(first.getStates());
-    newAutomaton.setBeginningStates(first.getBeginningStates());
-    newAutomaton.setTransitions(first.getTransitions());
-
-    int firstLastState = *(--newAutomaton.getStates().end());
+    int firstLastState = *first.getStates().rbegin();
 
-    for(int secondState : second.getStates()) {
-        newAutomaton.addState(secondState + firstLastState);
-        if (second.getFinalStates().count(secondState) != 0) newAutomaton.addFinalState(secondState + firstLastState);
-    }
-
-    for(auto transition : second.getTransitions()) {
-        newAutomaton.addTransition(std::make_pair(transition.first.first + firstLastState, transition.first.second + firstLastState), transition.second);   
-    }
+    Builder builder;
+    builder.addAutomaton(first, 0, true, false);
+    builder.addAutomaton(second, firstLastState, false, true);
 
     for(int firstEndingState : first.getFinalStates()) {
         for(int secondBeginningState : second.getBeginningStates()) {
-            newAutomaton.addTransition(std::make_pair(firstEndingState, secondBeginningState + firstLastState), {EPSILON});
+            builder.addTransition(std::make_pair(firstEndingState, secondBeginningState + firstLastState), EPSILON);
         }   
     }
 
-    return newAutomaton;
+    return builder.finalize();
 }
 
 Automaton Automaton::complement(const Automaton& automaton) {
-    Automaton newAutomaton = automaton;
-    std::set<int> newFinalStates;
+    std::set<char> alphabet;
+    for (int byte = 0; byte < 256; byte++) {
+        char letter = byte;
+        if (!Tokenizer::isSyntax(letter) && letter != '@' && letter != '?' && letter != EPSILON) alphabet.insert(letter);
+    }
+    return complement(automaton, alphabet);
+}
 
-    for (int i : automaton.states) {
-        if (automaton.finalStates.count(i) == 0) {
-            newFinalStates.insert(i);
-        }
+Automaton Automaton::complement(const Automaton& automaton, const std::set<char>& letters) {
+    std::array<bool, 256> alphabet{};
+    for (char letter : letters) {
+        if (letter == '?' || letter == EPSILON) throw std::runtime_error("Invalid alphabet letter!");
+        alphabet[(unsigned char) letter] = true;
     }
 
-    newAutomaton.setFinalStates(newFinalStates);
-    return newAutomaton;
+    //Without '?' in the alphabet every class is written as its letters, none of them as '?'.
+    CompactNfa::DeterministicTable dfa = automaton.getCompactNfa() -> determine();
+    dfa.complement(alphabet);
+    return fromDeterministicTable(dfa);
 }
 
 Automaton Automaton::iteration(const Automaton& automaton) {
-    Automaton newAutomaton = automaton;
+    Builder builder(automaton);
 
-    for (int finalState : newAutomaton.finalStates) {
-        for (int beginningState : newAutomaton.beginningStates) {
-            if (newAutomaton.neighbours.at(finalState).count(beginningState) == 0) {
-                newAutomaton.addTransition(std::make_pair(finalState, beginningState), {EPSILON});
-            }
-            if (newAutomaton.finalStates.count(beginningState) == 0) {
-                newAutomaton.addFinalState(beginningState);
-            }
+    for (int finalState : automaton.getFinalStates()) {
+        for (int beginningState : automaton.getBeginningStates()) {
+            builder.addTransition(std::make_pair(finalState, beginningState), EPSILON);
+            builder.addState(beginningState, false, true);
         }
     }
 
-    return newAutomaton;
+    return builder.finalize();
 }
 
-std::set<char> Automaton::getAlphabet() const {
-    std::set<char> alphabet;
-    for (auto transition : transitions) {
-        for (char letter : transition.second) {
-            if (letter != EPSILON) {
-                alphabet.insert(letter);
-            }
-        }
+Automaton Automaton::reverse(const Automaton& automaton) {
+    Builder builder;
+    for (int state : automaton.getStates()) {
+        builder.addState(state);
     }
-    return alphabet;
-}
-
-bool Automaton::equalSets(std::set<int> s1, std::set<int> s2) {
-    if (s1.size() == s2.size()) {
-        for (int x : s1) {
-            if (s2.count(x) == 0) return false;
-        }
-        return true; 
+    for (int beginningState : automaton.getFinalStates()) {
+        builder.addState(beginningState, true);
     }
-    else return false;
-}
-
-bool Automaton::containsInMainColumn(std::vector<std::vector<std::set<int>>> grid, std::set<int> state) {
-    for (int i = 0; i < grid.size(); i++) {
-        if (equalSets(grid[i][0], state)) return true;       
+    for (int finalState : automaton.getBeginningStates()) {
+        builder.addState(finalState, false, true);
     }
-    return false;
-}
-
-void Automaton::determine() {
-    std::set<char> alphabet = getAlphabet();
-    std::vector<std::vector<std::set<int>>> grid;
 
-    std::set<int> beginningState;
-    for (int begState : beginningStates) beginningState.insert(begState);
-
-    for(std::set<int>::iterator begState = beginningState.begin(); begState != beginningState.end(); begState++) {
-        for(auto transition : transitions) {
-            if (transition.second.count(EPSILON) > 0 && transition.first.first == *begState && beginningState.count(transition.first.second) == 0) {
-                beginningState.insert(transition.first.second);
-                begState = beginningState.begin();
-            }
+    for (auto& transition : automaton.getTransitions()) {
+        for (char letter : transition.second) {
+            builder.addTransition(std::make_pair(transition.first.second, transition.first.first), letter);
         }
     }
 
-    grid.push_back(std::vector<std::set<int>>(1 + alphabet.size()));
-    grid[0][0] = beginningState;
-    for (int i = 0; i < grid.size(); i++) {
-        for(int j = 1; j < grid[i].size(); j++) {
-            std::set<int> newState;
-            for (int state : grid[i][0]) {
-                for (auto transition : transitions) {
-                    if (transition.first.first == state && transition.second.count(*std::next(alphabet.begin(), j-1)) > 0) newState.insert(transition.first.second);
-                }
-            }
+    return builder.finalize();
+}
 
-            for(std::set<int>::iterator state = newState.begin(); state != newState.end(); state++) {
-                for(auto transition : transitions) {
-                    if (transition.second.count(EPSILON) > 0 && transition.first.first == *state && newState.count(transition.first.second) == 0) {
-                        newState.insert(transition.first.second);
-                        state = newState.begin();
-                    }
-                }
-            }
+Automaton Automaton::fromDeterministicTable(const CompactNfa::DeterministicTable& dfa) {
+    std::size_t letterCount = dfa.classCount;
 
-            grid[i][j] = newState;
-            if (!containsInMainColumn(grid, newState) && newState.size() > 0) {
-                grid.push_back(std::vector<std::set<int>>(1 + alphabet.size()));
-                grid.back()[0] = newState;
-            } 
-        }
-    }
+    Builder builder;
+    for (std::size_t i = 0; i < dfa.stateCount(); i++) {
+        builder.addState(i + 1, i == 0, dfa.isFinal(i));
 
-    std::vector<std::vector<int>> simpleGrid(grid.size(), std::vector<int>(grid[0].size()));
-    for(int i = 0; i < simpleGrid.size(); i++) simpleGrid[i][0] = i+1;
+        for (std::size_t column = 0; column < letterCount; column++) {
+            int target = dfa.table[i * letterCount + column];
+            if (target < 0) continue;
 
-    for (int i = 0; i < grid.size(); i++) {
-        for(int j = 1; j < grid[i].size(); j++) {
-            for(int n = 0; n < grid.size(); n++) {
-                if (equalSets(grid[n][0], grid[i][j])) simpleGrid[i][j] = n + 1;
+            for (char letter : dfa.classLetters[column]) {
+                builder.addTransition(std::make_pair(i + 1, target + 1), letter);
             }
         }
     }
 
-    Automaton newAutomaton;
-    for(int i = 0; i < simpleGrid.size(); i++) newAutomaton.addState(i+1);
-    newAutomaton.addBeginningState(1);
-
-    for (int i = 0; i < simpleGrid.size(); i++) {
-        for (int j = 1; j < simpleGrid[i].size(); j++) {
-            if (simpleGrid[i][j] > 0) newAutomaton.addTransition(std::make_pair(simpleGrid[i][0], simpleGrid[i][j]), {*std::next(alphabet.begin(), j - 1),});
-        }
-    }
-
-    for (int i = 0; i < grid.size(); i++) {
-        for(int endingState : finalStates) {
-            if (grid[i][0].count(endingState) != 0) newAutomaton.addFinalState(i+1);
-        }
-    }
-
-    *this = newAutomaton;
+    return builder.finalize();
 }
 
-void Automaton::readRegex(std::string regex) {
-    std::stringstream toShuntingYard;
-    toShuntingYard << regex;
-    Tokenizer t1(toShuntingYard);
+void Automaton::determine() {
+    *this = fromDeterministicTable(getCompactNfa() -> determine());
+}
 
-    std::stringstream toEval;
-    toEval << RegexUtils::shuntingYardAlgo(t1);
-    Tokenizer t2(toEval);
+void Automaton::minimize() {
+    CompactNfa::DeterministicTable dfa = getCompactNfa() -> determine();
+    dfa.minimize();
+    *this = fromDeterministicTable(dfa);
+}
 
-    *this = RegexUtils::evaluateRegex(t2);
+void Automaton::readRegex(std::string_view regex) {
+    *this = RegexUtils::parseRegex(regex);
 }
 
 std::string Automaton::convertToRegex() const {
-    Automaton newAutomaton = *this;
-    newAutomaton.determine();
-
-    std::stringstream result;
-
-    std::set<int> fStates = newAutomaton.finalStates;
-    result << RegexUtils::automatonToRegex(newAutomaton, *newAutomaton.beginningStates.begin(), *fStates.begin(), newAutomaton.states.size() + 1);
-    fStates.erase(fStates.begin());
-
-    for (int finalState : fStates) {
-        result << "+" << RegexUtils::automatonToRegex(newAutomaton, *newAutomaton.beginningStates.begin(), finalState, newAutomaton.states.size() + 1);
-    }
-
-    return result.str();
+    return RegexUtils::automatonToRegex(*this);
 }
 
 
@@ -4,7 +4,11 @@
 #include <iostream>
 #include <set>
 #include <map>
+#include <memory>
+#include <string_view>
 #include <vector>
+#include "CompiledAutomaton.hpp"
+#include "CompactNfa.hpp"
 
 #define EPSILON (char)238
 
@@ -18,73 +22,106 @@ public:
 
     /** Map of edge and the transition letters
      * 
-     *  Represents all transitions in the automaton.
+     *  Represents all transitions of an automaton passed to setTransitions().
      * 
      */
     using Transitions = std::map<Edge, TransitionLetters>;
 
-private:
-    ///All states.
-    std::set<int> states;
-
-    ///All beginning states.
-    std::set<int> beginningStates;
-
-    ///All final states
-    std::set<int> finalStates;
-    
-    ///All transitions
-    Transitions transitions;
-
-    /** Map of state and its neighbours. 
+    /** Collects states and transitions and creates the automaton from them at once.
      * 
-     *  Contains a state and a set of all states that can be directly accessed by the current state.
-     *  
+     *  Adding only appends to vectors. finalize() sorts everything and lays the automaton out
+     *  in its arena, so building an automaton with E transitions costs O(E log E).
      * 
      */
-    std::map<int, std::set<int>> neighbours; 
+    class Builder {
+    private:
+        friend class Automaton;
 
-    ///Copies another automaton
-    void copy(const Automaton&);
+        std::vector<int> states;
+        std::vector<int> beginningStates;
+        std::vector<int> finalStates;
+        std::vector<std::pair<Edge, char>> transitions;
 
-    ///Updates the neighbours map
-    void updateNeighbours();
+    public:
+        Builder() = default;
 
-    ///Checks if the given 2 sets are equal 
-    static bool equalSets(std::set<int>, std::set<int>);
+        ///Starts with the states and transitions of the automaton.
+        explicit Builder(const Automaton&);
 
-    /** Checks if the main column contains the given set
-     * 
+        ///Reserves space for the given number of states and transition letters.
+        void reserve(std::size_t, std::size_t);
+
+        void addState(int, bool = false, bool = false);
+        void addTransition(Edge, char);
+        void addTransitions(const std::vector<std::pair<Edge, char>>&);
+
+        /** Adds the states and transitions of the automaton with the offset added to every state.
+         * 
+         *  Its beginning and final states stay beginning and final only if the flags are set.
+         * 
+         */
+        void addAutomaton(const Automaton&, int offset, bool beginning, bool final);
+
+        ///Creates the automaton. The builder is empty afterwards.
+        Automaton finalize();
+    };
+
+private:
+    /** The states and transitions.
      * 
+     *  The automaton is immutable once built and shared by its copies, so copying an automaton
+     *  does not copy its transitions. Every change builds a new one.
      * 
      */
-    static bool containsInMainColumn(std::vector<std::vector<std::set<int>>>, std::set<int>);
-    
-    ///Gets automaton's alphabet
-    std::set<char> getAlphabet() const;
+    std::shared_ptr<const CompactNfa> nfa;
 
-    ///Gets the common letters in the both sets 
-    static TransitionLetters getCommonLetters (const TransitionLetters, const TransitionLetters);
+    ///Gets the automaton, an empty one for a default constructed or moved from automaton.
+    const CompactNfa& data() const;
+
+    /** Builds a deterministic automaton with states 1..n (1 is the beginning state) from the table
+     * 
+     *  A class of letters no transition mentions is written as '?', which also reads the other
+     *  letters. This does not change the language of a table made by determine(), where the
+     *  other letters lead to a superset of the states.
+     * 
+     */
+    static Automaton fromDeterministicTable(const CompactNfa::DeterministicTable&);
 
 public:
-    Automaton() = default;
-    Automaton(const Automaton&); 
+    /** Read-only access to the automaton.
+     * 
+     *  The states are sorted ranges and the transitions are sorted by their edge. The ranges
+     *  stay valid until the automaton is changed or destroyed. The letters of a transition that
+     *  reads every byte are reported as '?'.
+     * 
+     */
+    CompactNfa::LabelRange getStates() const;
+    CompactNfa::LabelRange getBeginningStates() const;
+    CompactNfa::LabelRange getFinalStates() const;
+    CompactNfa::TransitionRange getTransitions() const;
 
-    std::set<int> getStates() const;
-    std::set<int> getBeginningStates() const;
-    std::set<int> getFinalStates() const;
-    Transitions getTransitions() const;
+    ///Builds the map of every state to the states its transitions lead to.
     std::map<int, std::set<int>> getNeighbours() const;
 
-    void setStates(const std::set<int>);
-    void setBeginningStates(const std::set<int>);
-    void setFinalStates(const std:: set<int>);
-    void setTransitions(const Transitions);
+    ///Gets the automaton in its compact form, which is shared and not copied.
+    std::shared_ptr<const CompactNfa> getCompactNfa() const;
+
+    /** Changes the automaton.
+     * 
+     *  Every change builds the automaton anew in O(E log E), so use Builder to create one
+     *  state by state. The states always include the beginning and final states and the
+     *  states of the transitions.
+     * 
+     */
+    void setStates(const std::set<int>&);
+    void setBeginningStates(const std::set<int>&);
+    void setFinalStates(const std::set<int>&);
+    void setTransitions(const Transitions&);
 
-    void addState(const int, bool, bool);
+    void addState(const int, bool = false, bool = false);
     void addBeginningState(const int);
     void addFinalState(const int);
-    void addTransition(Edge, TransitionLetters);
+    void addTransition(Edge, const TransitionLetters&);
 
     /** Prints automaton's information.
      * 
@@ -93,33 +130,94 @@ public:
      */
     void printInfo() const;
 
-    ///Checks if the automaton recognizes the given word 
+    /** Checks if the automaton recognizes the given word 
+     * 
+     *  Simulates the automaton directly without determining it, which is the cheaper option for a
+     *  single word.
+     * 
+     */
     bool recognize(const std::string&) const; 
 
+    /** Compiles the automaton into an immutable deterministic matcher.
+     * 
+     *  Determinization is done once here, so matching many words should go through the result
+     *  instead of calling recognize() for each of them. If minimized is set, the automaton is
+     *  also minimized first, which gives a smaller table for a slower compilation.
+     * 
+     */
+    CompiledAutomaton compile(bool minimized = false) const;
+
+    /** Compiles the complement of the automaton into a deterministic matcher.
+     * 
+     *  The table is completed with a shared sink state and its final states are swapped
+     *  directly, so unlike compiling complement() it recognizes exactly the words over all 256
+     *  bytes the automaton does not, '?' and EPSILON included. Once reached, the sink ends the
+     *  match.
+     * 
+     */
+    CompiledAutomaton compileComplement(bool minimized = false) const;
+
     ///The union of 2 automatons
     static Automaton un(const Automaton&, const Automaton&);
 
-    ///The interesection of 2 automatons
+    /** The interesection of 2 automatons
+     * 
+     *  Only the pairs of states reachable from the pairs of beginning states are created, so the
+     *  work depends on the size of the result and not on the product of the state counts.
+     * 
+     */
     static Automaton intersection(const Automaton&, const Automaton&); 
 
     ///The concatenation of 2 automatons
     static Automaton concat(const Automaton&, const Automaton&); 
 
-    ///The complement of an automaton
+    /** The complement of an automaton
+     * 
+     *  The automaton is determined and every missing transition goes to a shared sink state
+     *  before the final states are swapped. The result is deterministic and recognizes the
+     *  words the automaton does not over the bytes a regular expression can write as letters:
+     *  all but whitespace, brackets, operators, '@', '?' and EPSILON. So convertToRegex() on the
+     *  result reads back as the same language. Use compileComplement() to match all bytes.
+     * 
+     */
     static Automaton complement(const Automaton&);  
 
+    /** The complement of an automaton over the given alphabet
+     * 
+     *  Recognizes the words of letters from the alphabet that the automaton does not. Throws
+     *  std::runtime_error if the alphabet contains '?' or EPSILON.
+     * 
+     */
+    static Automaton complement(const Automaton&, const std::set<char>&);
+
     ///The iteration of an automaton
     static Automaton iteration(const Automaton&);
 
+    /** The reversal of an automaton
+     * 
+     *  Recognizes the reversed words: every transition is turned around and the beginning and
+     *  final states are swapped.
+     * 
+     */
+    static Automaton reverse(const Automaton&);
+
     ///Converts the given regular expression into automaton.
-    void readRegex(const std::string);
+    void readRegex(std::string_view);
 
-    ///Converts the current automaton in a regular expression.
+    /** Converts the current automaton in a regular expression.
+     * 
+     *  The states are eliminated from the automaton as it is. It is not determined first, which
+     *  could make it exponentially bigger, so call minimize() before only if that makes it smaller.
+     * 
+     */
     std::string convertToRegex() const;
 
     ///Determines an automaton
     void determine();
 
+    ///Determines and minimizes an automaton
+    void minimize();
+
     ///Stream operator that calls the convertToRegex() function
     friend Automaton& operator >> (Automaton&, std::string&);
 
@@ -0,0 +1,629 @@
+#include "CompactNfa.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include "Automaton.hpp"
+
+std::size_t CompactNfa::StateSetHash::operator()(const std::vector<int>& states) const {
+    std::size_t hash = 14695981039346656037ull;
+    for (int state : states) {
+        hash = (hash ^ (std::size_t) state) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::size_t CompactNfa::LabelRange::count(int label) const {
+    return std::binary_search(first, last, label);
+}
+
+CompactNfa::Letters::Letters(const std::uint32_t* mask, bool epsilon) : mask(mask), epsilon(epsilon) {
+    full = mask != nullptr && std::all_of(mask, mask + MASK_WORDS, [](std::uint32_t word) { return word == UINT32_MAX; });
+}
+
+std::size_t CompactNfa::Letters::count(char letter) const {
+    if (letter == EPSILON) return epsilon;
+    if (mask == nullptr) return 0;
+    return full ? letter == '?' : maskContains(mask, letter);
+}
+
+CompactNfa::Letters::iterator CompactNfa::Letters::begin() const {
+    iterator first(this, CHAR_MIN);
+    return count(CHAR_MIN) != 0 ? first : ++first;
+}
+
+CompactNfa::Letters::iterator& CompactNfa::Letters::iterator::operator++() {
+    do {
+        letter++;
+    } while (letter <= CHAR_MAX && letters -> count((char) letter) == 0);
+    return *this;
+}
+
+std::size_t CompactNfa::Letters::size() const {
+    std::size_t size = epsilon;
+    if (full) return size + 1;
+    for (std::size_t word = 0; mask != nullptr && word < MASK_WORDS; word++) {
+        for (std::uint32_t bits = mask[word]; bits != 0; bits &= bits - 1) size++;
+    }
+    return size;
+}
+
+CompactNfa::TransitionIterator::TransitionIterator(const CompactNfa* nfa, std::size_t state, std::size_t letterEdge, std::size_t epsilonEdge)
+    : nfa(nfa), state(state), letterEdge(letterEdge), epsilonEdge(epsilonEdge) {
+    settle();
+}
+
+void CompactNfa::TransitionIterator::settle() {
+    std::size_t states = nfa -> stateCount();
+    while (state < states && letterEdge == nfa -> letterEdgesEnd(state) && epsilonEdge == nfa -> epsilonEdgesEnd(state)) {
+        state++;
+    }
+    if (state == states) return;
+
+    const std::uint32_t* epsilonTargets = nfa -> array(nfa -> epsilonTargetOffset);
+    bool letters = letterEdge < nfa -> letterEdgesEnd(state);
+    bool epsilon = epsilonEdge < nfa -> epsilonEdgesEnd(state);
+    target = std::min<std::uint32_t>(letters ? nfa -> getEdgeTarget(letterEdge) : UINT32_MAX, epsilon ? epsilonTargets[epsilonEdge] : UINT32_MAX);
+
+    letters = letters && (std::uint32_t) nfa -> getEdgeTarget(letterEdge) == target;
+    epsilon = epsilon && epsilonTargets[epsilonEdge] == target;
+    transition.first = std::make_pair(nfa -> getLabel(state), nfa -> getLabel(target));
+    transition.second = Letters(letters ? nfa -> getEdgeMask(letterEdge) : nullptr, epsilon);
+}
+
+CompactNfa::TransitionIterator& CompactNfa::TransitionIterator::operator++() {
+    if (transition.second.count(EPSILON) != 0) epsilonEdge++;
+    if (letterEdge < nfa -> letterEdgesEnd(state) && (std::uint32_t) nfa -> getEdgeTarget(letterEdge) == target) letterEdge++;
+    settle();
+    return *this;
+}
+
+CompactNfa::TransitionIterator CompactNfa::TransitionRange::begin() const {
+    return TransitionIterator(nfa, 0, 0, 0);
+}
+
+CompactNfa::TransitionIterator CompactNfa::TransitionRange::end() const {
+    return TransitionIterator(nfa, nfa -> stateCount(), nfa -> letterEdgeCount, nfa -> epsilonEdgeCount);
+}
+
+std::size_t CompactNfa::DeterministicTable::stateCount() const {
+    return stateSets.size();
+}
+
+bool CompactNfa::DeterministicTable::isFinal(std::size_t state) const {
+    return !acceptedPatterns[state].empty();
+}
+
+CompactNfa::CompactNfa() {
+    allocate();
+}
+
+CompactNfa::CompactNfa(std::vector<int> stateLabels, std::vector<int> beginning, std::vector<int> finals, std::vector<std::pair<std::pair<int, int>, char>> transitions) {
+    auto sortUnique = [](auto& values) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    };
+
+    for (auto& transition : transitions) {
+        stateLabels.push_back(transition.first.first);
+        stateLabels.push_back(transition.first.second);
+    }
+    stateLabels.insert(stateLabels.end(), beginning.begin(), beginning.end());
+    stateLabels.insert(stateLabels.end(), finals.begin(), finals.end());
+    sortUnique(stateLabels);
+    sortUnique(beginning);
+    sortUnique(finals);
+    sortUnique(transitions);
+
+    //Every label is in the index, the ids follow the order of the labels.
+    auto id = [&](int label) {
+        return (std::uint32_t) (std::lower_bound(stateLabels.begin(), stateLabels.end(), label) - stateLabels.begin());
+    };
+
+    //The transitions are sorted by their edge, so the letters of every edge are one run.
+    auto forEachEdge = [&](auto visit) {
+        for (std::size_t first = 0, last = 0; first < transitions.size(); first = last) {
+            bool letters = false, epsilon = false;
+            for (last = first; last < transitions.size() && transitions[last].first == transitions[first].first; last++) {
+                (transitions[last].second == EPSILON ? epsilon : letters) = true;
+            }
+            visit(first, last, letters, epsilon);
+        }
+    };
+
+    states = stateLabels.size();
+    beginningStateCount = beginning.size();
+    finalStateCount = finals.size();
+    forEachEdge([&](std::size_t, std::size_t, bool letters, bool epsilon) {
+        letterEdgeCount += letters;
+        epsilonEdgeCount += epsilon;
+    });
+    allocate();
+
+    std::uint32_t* letterStart = array(letterStartOffset);
+    std::uint32_t* letterTargets = array(letterTargetOffset);
+    std::uint32_t* letterMasks = array(letterMaskOffset);
+    std::uint32_t* epsilonStart = array(epsilonStartOffset);
+    std::uint32_t* epsilonTargets = array(epsilonTargetOffset);
+    std::uint32_t* alphabet = array(alphabetOffset);
+
+    //The labels and the ids are in the same order, so the rows are filled in order.
+    std::size_t letterEdge = 0, epsilonEdge = 0;
+    forEachEdge([&](std::size_t first, std::size_t last, bool letters, bool epsilon) {
+        std::uint32_t from = id(transitions[first].first.first);
+        std::uint32_t to = id(transitions[first].first.second);
+
+        if (epsilon) {
+            epsilonStart[from + 1]++;
+            epsilonTargets[epsilonEdge++] = to;
+        }
+        if (!letters) return;
+
+        letterStart[from + 1]++;
+        letterTargets[letterEdge] = to;
+        std::uint32_t* mask = letterMasks + letterEdge++ * MASK_WORDS;
+        for (std::size_t i = first; i < last; i++) {
+            char letter = transitions[i].second;
+            unsigned char byte = letter;
+            if (letter == EPSILON) continue;
+
+            if (letter == '?') {
+                std::fill(mask, mask + MASK_WORDS, UINT32_MAX);
+            }
+            else {
+                mask[byte >> 5] |= 1u << (byte & 31);
+                alphabet[byte >> 5] |= 1u << (byte & 31);
+            }
+        }
+    });
+
+    for (std::size_t state = 0; state < states; state++) {
+        letterStart[state + 1] += letterStart[state];
+        epsilonStart[state + 1] += epsilonStart[state];
+    }
+
+    std::copy(stateLabels.begin(), stateLabels.end(), array(labelOffset));
+    std::copy(beginning.begin(), beginning.end(), array(beginningLabelOffset));
+    std::copy(finals.begin(), finals.end(), array(finalLabelOffset));
+
+    std::uint32_t* finalPatterns = array(finalPatternOffset);
+    std::fill(finalPatterns, finalPatterns + states, (std::uint32_t) -1);
+    for (int finalState : finals) {
+        finalPatterns[id(finalState)] = 0;
+    }
+
+    std::uint32_t* beginningStates = array(beginningStateOffset);
+    for (int beginningState : beginning) {
+        *beginningStates++ = id(beginningState);
+    }
+}
+
+CompactNfa::CompactNfa(const Automaton& automaton, const std::map<int, int>& patterns) : CompactNfa(*automaton.getCompactNfa()) {
+    std::uint32_t* finalPatterns = array(finalPatternOffset);
+    for (auto& pattern : patterns) {
+        int state = getState(pattern.first);
+        if (state >= 0 && isFinal(state)) finalPatterns[state] = pattern.second;
+    }
+}
+
+void CompactNfa::allocate() {
+    letterStartOffset = 0;
+    letterTargetOffset = letterStartOffset + states + 1;
+    letterMaskOffset = letterTargetOffset + letterEdgeCount;
+    epsilonStartOffset = letterMaskOffset + letterEdgeCount * MASK_WORDS;
+    epsilonTargetOffset = epsilonStartOffset + states + 1;
+    finalPatternOffset = epsilonTargetOffset + epsilonEdgeCount;
+    beginningStateOffset = finalPatternOffset + states;
+    alphabetOffset = beginningStateOffset + beginningStateCount;
+    labelOffset = alphabetOffset + MASK_WORDS;
+    beginningLabelOffset = labelOffset + states;
+    finalLabelOffset = beginningLabelOffset + beginningStateCount;
+
+    arena.assign(finalLabelOffset + finalStateCount, 0);
+}
+
+std::size_t CompactNfa::stateCount() const {
+    return states;
+}
+
+CompactNfa::StateRange CompactNfa::getBeginningStates() const {
+    return {array(beginningStateOffset), array(beginningStateOffset) + beginningStateCount};
+}
+
+int CompactNfa::getState(int label) const {
+    LabelRange all = getStateLabels();
+    const int* found = std::lower_bound(all.begin(), all.end(), label);
+    return found != all.end() && *found == label ? found - all.begin() : -1;
+}
+
+CompactNfa::LabelRange CompactNfa::getStateLabels() const {
+    return labels(labelOffset, states);
+}
+
+CompactNfa::LabelRange CompactNfa::getBeginningLabels() const {
+    return labels(beginningLabelOffset, beginningStateCount);
+}
+
+CompactNfa::LabelRange CompactNfa::getFinalLabels() const {
+    return labels(finalLabelOffset, finalStateCount);
+}
+
+CompactNfa::TransitionRange CompactNfa::getTransitions() const {
+    return {this};
+}
+
+bool CompactNfa::isFinal(int state) const {
+    return (int) array(finalPatternOffset)[state] >= 0;
+}
+
+bool CompactNfa::isExplicitLetter(char letter) const {
+    return maskContains(array(alphabetOffset), letter);
+}
+
+std::vector<int> CompactNfa::getAcceptedPatterns(const std::vector<int>& states) const {
+    const std::uint32_t* finalPatterns = array(finalPatternOffset);
+
+    std::vector<int> patterns;
+    for (int state : states) {
+        if ((int) finalPatterns[state] >= 0) patterns.push_back(finalPatterns[state]);
+    }
+
+    std::sort(patterns.begin(), patterns.end());
+    patterns.erase(std::unique(patterns.begin(), patterns.end()), patterns.end());
+    return patterns;
+}
+
+std::size_t CompactNfa::getByteClasses(std::array<std::uint8_t, 256>& byteClasses) const {
+    using Mask = std::array<std::uint32_t, MASK_WORDS>;
+
+    //Every distinct mask splits the classes into the bytes it contains and the rest.
+    std::vector<Mask> masks(letterEdgeCount + 1);
+    const std::uint32_t* letterMasks = array(letterMaskOffset);
+    for (std::size_t edge = 0; edge < letterEdgeCount; edge++) {
+        std::copy(letterMasks + edge * MASK_WORDS, letterMasks + (edge + 1) * MASK_WORDS, masks[edge].begin());
+    }
+    std::copy(array(alphabetOffset), array(alphabetOffset) + MASK_WORDS, masks.back().begin());
+    std::sort(masks.begin(), masks.end());
+    masks.erase(std::unique(masks.begin(), masks.end()), masks.end());
+
+    byteClasses.fill(0);
+    std::size_t classCount = 1;
+    std::array<int, 512> split;
+    for (const Mask& mask : masks) {
+        split.fill(-1);
+        std::size_t newCount = 0;
+        for (int byte = 0; byte < 256; byte++) {
+            int key = byteClasses[byte] * 2 + maskContains(mask.data(), (char) byte);
+            if (split[key] < 0) split[key] = newCount++;
+            byteClasses[byte] = split[key];
+        }
+        classCount = newCount;
+    }
+
+    return classCount;
+}
+
+void CompactNfa::addClosure(SparseSet& set, int state, std::vector<int>& stack) const {
+    if (!set.insert(state)) return;
+
+    stack.push_back(state);
+    while (!stack.empty()) {
+        int top = stack.back();
+        stack.pop_back();
+
+        for (int vert : getEpsilonEdges(top)) {
+            if (set.insert(vert)) stack.push_back(vert);
+        }
+    }
+}
+
+void CompactNfa::step(const SparseSet& from, char letter, SparseSet& to, std::vector<int>& stack) const {
+    for (int state : from) {
+        for (std::size_t edge = letterEdgesBegin(state); edge < letterEdgesEnd(state); edge++) {
+            if (edgeReads(edge, letter)) addClosure(to, getEdgeTarget(edge), stack);
+        }
+    }
+}
+
+CompactNfa::DeterministicTable CompactNfa::determine() const {
+    DeterministicTable result;
+    result.classCount = getByteClasses(result.byteClasses);
+    std::size_t letterCount = result.classCount;
+
+    //Classes with a byte no transition mentions are read only by '?'.
+    std::vector<char> representatives(letterCount);
+    result.classLetters.resize(letterCount);
+    for (int byte = 255; byte >= 0; byte--) {
+        std::uint8_t byteClass = result.byteClasses[byte];
+        representatives[byteClass] = (char) byte;
+        if (!isExplicitLetter((char) byte)) {
+            result.classLetters[byteClass] = "?";
+        }
+    }
+    for (int byte = 0; byte < 256; byte++) {
+        std::string& letters = result.classLetters[result.byteClasses[byte]];
+        if (letters != "?" && isExplicitLetter((char) byte)) letters.push_back((char) byte);
+    }
+
+    //The targets of every state grouped by byte class.
+    std::vector<std::vector<int>> moves(stateCount() * letterCount);
+    for (std::size_t state = 0; state < stateCount(); state++) {
+        for (std::size_t edge = letterEdgesBegin(state); edge < letterEdgesEnd(state); edge++) {
+            for (std::size_t column = 0; column < letterCount; column++) {
+                if (edgeReads(edge, representatives[column])) moves[state * letterCount + column].push_back(getEdgeTarget(edge));
+            }
+        }
+    }
+
+    std::unordered_map<std::vector<int>, int, StateSetHash> ids;
+    SparseSet reached(stateCount());
+    std::vector<int> stack;
+
+    for (int beginningState : getBeginningStates()) {
+        addClosure(reached, beginningState, stack);
+    }
+    std::vector<int> beginningSet(reached.begin(), reached.end());
+    std::sort(beginningSet.begin(), beginningSet.end());
+    ids.emplace(beginningSet, 0);
+    result.acceptedPatterns.push_back(getAcceptedPatterns(beginningSet));
+    result.stateSets.push_back(std::move(beginningSet));
+
+    for (std::size_t current = 0; current < result.stateSets.size(); current++) {
+        for (std::size_t column = 0; column < letterCount; column++) {
+            reached.clear();
+            for (int state : result.stateSets[current]) {
+                for (int to : moves[state * letterCount + column]) {
+                    addClosure(reached, to, stack);
+                }
+            }
+
+            int target = -1;
+            if (!reached.empty()) {
+                std::vector<int> targetSet(reached.begin(), reached.end());
+                std::sort(targetSet.begin(), targetSet.end());
+
+                auto inserted = ids.emplace(targetSet, result.stateSets.size());
+                if (inserted.second) {
+                    result.acceptedPatterns.push_back(getAcceptedPatterns(targetSet));
+                    result.stateSets.push_back(std::move(targetSet));
+                }
+                target = inserted.first -> second;
+            }
+            result.table.push_back(target);
+        }
+    }
+
+    return result;
+}
+
+void CompactNfa::DeterministicTable::complement(const std::array<bool, 256>& alphabet) {
+    //Class i * 2 + 1 holds the bytes of class i in the alphabet, class i * 2 the others.
+    std::vector<int> splitClasses(classCount * 2, -1);
+    std::vector<std::size_t> oldClasses;
+    std::vector<bool> readable;
+    std::array<std::uint8_t, 256> newByteClasses{};
+    for (int byte = 0; byte < 256; byte++) {
+        std::size_t key = byteClasses[byte] * 2 + alphabet[byte];
+        if (splitClasses[key] < 0) {
+            splitClasses[key] = oldClasses.size();
+            oldClasses.push_back(byteClasses[byte]);
+            readable.push_back(alphabet[byte]);
+        }
+        newByteClasses[byte] = splitClasses[key];
+    }
+    std::size_t newClassCount = oldClasses.size();
+
+    //A class of letters no transition mentions stays "?" only if none of its bytes was split off.
+    std::vector<std::string> newClassLetters(newClassCount);
+    for (std::size_t byteClass = 0; byteClass < newClassCount; byteClass++) {
+        std::size_t oldClass = oldClasses[byteClass];
+        if (!readable[byteClass]) continue;
+
+        if (classLetters[oldClass] == "?" && splitClasses[oldClass * 2] < 0) {
+            newClassLetters[byteClass] = "?";
+            continue;
+        }
+        for (int byte = 0; byte < 256; byte++) {
+            if (newByteClasses[byte] == byteClass && (char) byte != '?' && (char) byte != EPSILON) newClassLetters[byteClass] += (char) byte;
+        }
+    }
+
+    std::size_t states = stateCount();
+    bool needsSink = false;
+    for (std::size_t state = 0; state < states && !needsSink; state++) {
+        for (std::size_t byteClass = 0; byteClass < newClassCount && !needsSink; byteClass++) {
+            needsSink = readable[byteClass] && table[state * classCount + oldClasses[byteClass]] < 0;
+        }
+    }
+    int sink = states;
+    std::size_t newStates = states + needsSink;
+
+    std::vector<int> newTable(newStates * newClassCount, -1);
+    for (std::size_t state = 0; state < newStates; state++) {
+        for (std::size_t byteClass = 0; byteClass < newClassCount; byteClass++) {
+            if (!readable[byteClass]) continue;
+
+            int target = (int) state == sink ? sink : table[state * classCount + oldClasses[byteClass]];
+            newTable[state * newClassCount + byteClass] = target < 0 ? sink : target;
+        }
+    }
+
+    if (needsSink) {
+        stateSets.emplace_back();
+        acceptedPatterns.emplace_back();
+    }
+    for (std::vector<int>& patterns : acceptedPatterns) {
+        patterns = patterns.empty() ? std::vector<int>{0} : std::vector<int>();
+    }
+
+    byteClasses = newByteClasses;
+    classCount = newClassCount;
+    classLetters = std::move(newClassLetters);
+    table = std::move(newTable);
+}
+
+void CompactNfa::DeterministicTable::minimize() {
+    std::size_t letterCount = classCount;
+    std::size_t count = stateCount() + 1;
+    int deadState = stateCount();
+
+    auto target = [&](std::size_t state, std::size_t column) {
+        if ((int) state == deadState) return deadState;
+        int to = table[state * letterCount + column];
+        return to < 0 ? deadState : to;
+    };
+
+    //Incoming transitions of every state per letter, stored contiguously.
+    std::vector<std::size_t> incomingStart(count * letterCount + 1, 0);
+    std::vector<int> incoming(count * letterCount);
+    for (std::size_t state = 0; state < count; state++) {
+        for (std::size_t column = 0; column < letterCount; column++) {
+            incomingStart[target(state, column) * letterCount + column + 1]++;
+        }
+    }
+    for (std::size_t i = 1; i < incomingStart.size(); i++) {
+        incomingStart[i] += incomingStart[i - 1];
+    }
+    std::vector<std::size_t> fill(incomingStart.begin(), incomingStart.end() - 1);
+    for (std::size_t state = 0; state < count; state++) {
+        for (std::size_t column = 0; column < letterCount; column++) {
+            incoming[fill[target(state, column) * letterCount + column]++] = state;
+        }
+    }
+
+    //The blocks are contiguous ranges of elements, the marked states are moved to the front of their block.
+    std::vector<int> elements(count), location(count), blockOf(count);
+    std::vector<std::size_t> blockBegin, blockEnd, markedCount;
+    std::vector<bool> waiting;
+    std::vector<int> worklist, touched;
+
+    //The first partition puts together the states accepting the same patterns.
+    std::map<std::vector<int>, std::vector<int>> initialBlocks;
+    for (std::size_t state = 0; state < count; state++) {
+        initialBlocks[(int) state == deadState ? std::vector<int>() : acceptedPatterns[state]].push_back(state);
+    }
+
+    std::size_t position = 0;
+    for (auto& initialBlock : initialBlocks) {
+        worklist.push_back(blockBegin.size());
+        blockBegin.push_back(position);
+        for (int state : initialBlock.second) {
+            elements[position] = state;
+            location[state] = position++;
+            blockOf[state] = worklist.back();
+        }
+        blockEnd.push_back(position);
+        markedCount.push_back(0);
+        waiting.push_back(true);
+    }
+
+    std::vector<int> splitter;
+    while (!worklist.empty()) {
+        int block = worklist.back();
+        worklist.pop_back();
+        waiting[block] = false;
+        splitter.assign(elements.begin() + blockBegin[block], elements.begin() + blockEnd[block]);
+
+        for (std::size_t column = 0; column < letterCount; column++) {
+            for (int state : splitter) {
+                std::size_t edges = state * letterCount + column;
+                for (std::size_t i = incomingStart[edges]; i < incomingStart[edges + 1]; i++) {
+                    int from = incoming[i];
+                    int fromBlock = blockOf[from];
+                    std::size_t marked = blockBegin[fromBlock] + markedCount[fromBlock];
+                    if ((std::size_t) location[from] < marked) continue;
+
+                    int other = elements[marked];
+                    std::swap(elements[location[from]], elements[marked]);
+                    location[other] = location[from];
+                    location[from] = marked;
+
+                    if (markedCount[fromBlock]++ == 0) touched.push_back(fromBlock);
+                }
+            }
+
+            for (int touchedBlock : touched) {
+                std::size_t marked = markedCount[touchedBlock];
+                markedCount[touchedBlock] = 0;
+                if (marked == blockEnd[touchedBlock] - blockBegin[touchedBlock]) continue;
+
+                //The marked states become a new block.
+                int newBlock = blockBegin.size();
+                blockBegin.push_back(blockBegin[touchedBlock]);
+                blockEnd.push_back(blockBegin[touchedBlock] + marked);
+                markedCount.push_back(0);
+                blockBegin[touchedBlock] += marked;
+                for (std::size_t i = blockBegin[newBlock]; i < blockEnd[newBlock]; i++) {
+                    blockOf[elements[i]] = newBlock;
+                }
+
+                if (waiting[touchedBlock]) {
+                    waiting.push_back(true);
+                    worklist.push_back(newBlock);
+                }
+                else {
+                    std::size_t newSize = blockEnd[newBlock] - blockBegin[newBlock];
+                    std::size_t oldSize = blockEnd[touchedBlock] - blockBegin[touchedBlock];
+                    int smaller = newSize <= oldSize ? newBlock : touchedBlock;
+                    waiting.push_back(smaller == newBlock);
+                    waiting[smaller] = true;
+                    worklist.push_back(smaller);
+                }
+            }
+            touched.clear();
+        }
+    }
+
+    //Numbers the blocks in the order they are reached from the beginning state, the dead block is dropped.
+    int deadBlock = blockOf[deadState];
+    std::vector<int> newId(blockBegin.size(), -1);
+    std::vector<int> representatives;
+    if (blockOf[0] != deadBlock) {
+        newId[blockOf[0]] = 0;
+        representatives.push_back(0);
+    }
+    for (std::size_t i = 0; i < representatives.size(); i++) {
+        for (std::size_t column = 0; column < letterCount; column++) {
+            int to = blockOf[target(representatives[i], column)];
+            if (to != deadBlock && newId[to] < 0) {
+                newId[to] = representatives.size();
+                representatives.push_back(elements[blockBegin[to]]);
+            }
+        }
+    }
+
+    DeterministicTable result;
+    result.byteClasses = byteClasses;
+    result.classCount = classCount;
+    result.classLetters = classLetters;
+    if (representatives.empty()) {
+        //The language is empty, only the beginning state is left.
+        result.stateSets.push_back(std::vector<int>());
+        result.acceptedPatterns.push_back(std::vector<int>());
+        result.table.assign(letterCount, -1);
+        *this = std::move(result);
+        return;
+    }
+
+    result.stateSets.resize(representatives.size());
+    result.acceptedPatterns.resize(representatives.size());
+    for (std::size_t state = 0; state + 1 < count; state++) {
+        int id = newId[blockOf[state]];
+        if (id < 0) continue;
+        result.stateSets[id].insert(result.stateSets[id].end(), stateSets[state].begin(), stateSets[state].end());
+        result.acceptedPatterns[id] = acceptedPatterns[state];
+    }
+    for (std::vector<int>& states : result.stateSets) {
+        std::sort(states.begin(), states.end());
+        states.erase(std::unique(states.begin(), states.end()), states.end());
+    }
+
+    for (int representative : representatives) {
+        for (std::size_t column = 0; column < letterCount; column++) {
+            result.table.push_back(newId[blockOf[target(representative, column)]]);
+        }
+    }
+
+    *this = std::move(result);
+}
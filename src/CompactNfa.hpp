@@ -0,0 +1,361 @@
+#ifndef __COMPACT_NFA_HPP_
+#define __COMPACT_NFA_HPP_
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "SparseSet.hpp"
+
+class Automaton;
+
+/** Immutable storage of an automaton with dense state ids.
+ *
+ *  The states of the automaton are renumbered to 0..n-1 in the order of their labels, the
+ *  numbers the automaton was built with. The transitions are stored in compressed rows: the
+ *  letter transitions of state s are the edges letterStart[s] to letterStart[s + 1] - 1, and
+ *  every edge has one target and a 256-bit mask of the letters it reads ('?' sets every bit).
+ *  Epsilon transitions are stored the same way without masks. The edges of a row are sorted
+ *  by their target.
+ *
+ *  All arrays are parts of a single block of memory, so the automaton is created with one
+ *  allocation and copied with one memcpy. Automaton keeps its states and transitions only
+ *  here and shares them between its copies.
+ *
+ */
+class CompactNfa {
+public:
+    ///Number of 32-bit words in a letter mask.
+    static constexpr std::size_t MASK_WORDS = 8;
+
+    ///A range of states stored in the arena.
+    struct StateRange {
+        const std::uint32_t* first;
+        const std::uint32_t* last;
+
+        const std::uint32_t* begin() const { return first; }
+        const std::uint32_t* end() const { return last; }
+        std::size_t size() const { return last - first; }
+    };
+
+    ///A sorted range of state labels stored in the arena.
+    struct LabelRange {
+        const int* first;
+        const int* last;
+
+        const int* begin() const { return first; }
+        const int* end() const { return last; }
+        std::reverse_iterator<const int*> rbegin() const { return std::reverse_iterator<const int*>(last); }
+        std::reverse_iterator<const int*> rend() const { return std::reverse_iterator<const int*>(first); }
+        std::size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+
+        ///Returns 1 if the label is in the range and 0 otherwise, like std::set::count().
+        std::size_t count(int) const;
+    };
+
+    /** The letters of one transition, iterated in the order of a std::set<char>.
+     *
+     *  A letter edge that reads every byte is reported as the single letter '?'.
+     *
+     */
+    class Letters {
+    private:
+        ///The mask of the letter edge, nullptr if the transition has none.
+        const std::uint32_t* mask = nullptr;
+        bool full = false;
+        bool epsilon = false;
+
+    public:
+        class iterator {
+        private:
+            const Letters* letters;
+            int letter;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = char;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const char*;
+            using reference = char;
+
+            iterator(const Letters* letters, int letter) : letters(letters), letter(letter) {}
+
+            char operator*() const { return (char) letter; }
+            iterator& operator++();
+            bool operator==(const iterator& other) const { return letter == other.letter; }
+            bool operator!=(const iterator& other) const { return letter != other.letter; }
+        };
+
+        Letters() = default;
+        Letters(const std::uint32_t* mask, bool epsilon);
+
+        iterator begin() const;
+        iterator end() const { return iterator(this, CHAR_MAX + 1); }
+        std::size_t size() const;
+        bool empty() const { return mask == nullptr && !epsilon; }
+        std::size_t count(char) const;
+    };
+
+    ///A transition as the labels of its states and its letters.
+    using Transition = std::pair<std::pair<int, int>, Letters>;
+
+    /** Iterates the transitions sorted by their source and target labels.
+     *
+     *  The letter and the epsilon edges of a state are merged by target. The transition is kept
+     *  inside the iterator, so a reference to it is valid until the iterator moves.
+     *
+     */
+    class TransitionIterator {
+    private:
+        const CompactNfa* nfa;
+        std::size_t state, letterEdge, epsilonEdge;
+        std::uint32_t target = 0;
+        Transition transition;
+
+        ///Skips the states without edges left and reads the next transition.
+        void settle();
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Transition;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Transition*;
+        using reference = const Transition&;
+
+        TransitionIterator(const CompactNfa*, std::size_t state, std::size_t letterEdge, std::size_t epsilonEdge);
+
+        const Transition& operator*() const { return transition; }
+        const Transition* operator->() const { return &transition; }
+        TransitionIterator& operator++();
+
+        bool operator==(const TransitionIterator& other) const {
+            return state == other.state && letterEdge == other.letterEdge && epsilonEdge == other.epsilonEdge;
+        }
+        bool operator!=(const TransitionIterator& other) const { return !(*this == other); }
+    };
+
+    struct TransitionRange {
+        const CompactNfa* nfa;
+
+        TransitionIterator begin() const;
+        TransitionIterator end() const;
+    };
+
+    ///Hash of a sorted set of states.
+    struct StateSetHash {
+        std::size_t operator()(const std::vector<int>&) const;
+    };
+
+    /** Result of the subset construction.
+     *
+     *  State 0 is the beginning state. The letters are grouped in byte classes, the table has
+     *  one row per state and one column per byte class, a missing transition is -1.
+     *
+     */
+    struct DeterministicTable {
+        ///Maps every byte to its class.
+        std::array<std::uint8_t, 256> byteClasses{};
+
+        ///Number of byte classes.
+        std::size_t classCount = 0;
+
+        /** The letters of every byte class in the regular expression alphabet.
+         *
+         *  A class that contains a letter no transition mentions explicitly is "?".
+         *
+         */
+        std::vector<std::string> classLetters;
+
+        std::vector<int> table;
+
+        ///The sorted automaton states of every deterministic state.
+        std::vector<std::vector<int>> stateSets;
+
+        ///The sorted ids of the patterns accepted in every deterministic state (empty if it is not final).
+        std::vector<std::vector<int>> acceptedPatterns;
+
+        std::size_t stateCount() const;
+        bool isFinal(std::size_t) const;
+
+        /** Merges all equivalent states with Hopcroft's partition refinement.
+         *
+         *  Missing transitions are treated as going to an implicit dead state, and states
+         *  equivalent to it are dropped. States accepting different patterns are never merged.
+         *  Runs in O(k * n * log n) for n states and k byte classes. The automaton states of a
+         *  merged state are the union of the merged ones.
+         *
+         */
+        void minimize();
+
+        /** Turns the table into one for the words over the alphabet it does not recognize.
+         *
+         *  Every class is split into the bytes in the alphabet and the others, which are never
+         *  read. Every missing transition on a byte of the alphabet goes to a single sink state
+         *  that reads the whole alphabet, and then the final and the other states are swapped.
+         *  The sink is added only if some transition is missing. All final states accept
+         *  pattern 0.
+         *
+         */
+        void complement(const std::array<bool, 256>&);
+    };
+
+private:
+    ///Number of states.
+    std::size_t states = 0;
+
+    ///Number of letter edges.
+    std::size_t letterEdgeCount = 0;
+
+    ///Number of epsilon edges.
+    std::size_t epsilonEdgeCount = 0;
+
+    ///Number of beginning states.
+    std::size_t beginningStateCount = 0;
+
+    ///Number of final states.
+    std::size_t finalStateCount = 0;
+
+    ///Offsets of the arrays inside the arena (in 32-bit words).
+    std::size_t letterStartOffset = 0, letterTargetOffset = 0, letterMaskOffset = 0;
+    std::size_t epsilonStartOffset = 0, epsilonTargetOffset = 0;
+    std::size_t finalPatternOffset = 0, beginningStateOffset = 0, alphabetOffset = 0;
+    std::size_t labelOffset = 0, beginningLabelOffset = 0, finalLabelOffset = 0;
+
+    ///All arrays of the automaton.
+    std::vector<std::uint32_t> arena;
+
+    ///Lays the arrays out in the arena.
+    void allocate();
+
+    const std::uint32_t* array(std::size_t offset) const {
+        return arena.data() + offset;
+    }
+
+    std::uint32_t* array(std::size_t offset) {
+        return arena.data() + offset;
+    }
+
+    std::size_t epsilonEdgesEnd(int state) const {
+        return array(epsilonStartOffset)[state + 1];
+    }
+
+    LabelRange labels(std::size_t offset, std::size_t count) const {
+        const int* first = reinterpret_cast<const int*>(array(offset));
+        return {first, first + count};
+    }
+
+public:
+    ///Creates an automaton without states.
+    CompactNfa();
+
+    /** Creates the automaton from the parts collected by Automaton::Builder.
+     *
+     *  Every beginning and final state and every endpoint of a transition is a state as well,
+     *  duplicates are allowed. All final states accept pattern 0.
+     *
+     */
+    CompactNfa(std::vector<int> states, std::vector<int> beginningStates, std::vector<int> finalStates, std::vector<std::pair<std::pair<int, int>, char>> transitions);
+
+    /** Copies the automaton with the pattern accepted in every final state.
+     *
+     *  The map goes from a final state of the automaton to the id of its pattern, final states
+     *  that are not in it accept pattern 0.
+     *
+     */
+    CompactNfa(const Automaton&, const std::map<int, int>&);
+
+    std::size_t stateCount() const;
+    bool isFinal(int) const;
+
+    ///Gets the label of the state.
+    int getLabel(int state) const {
+        return labels(labelOffset, states).first[state];
+    }
+
+    ///Gets the state with the label, or -1 if there is none.
+    int getState(int label) const;
+
+    ///The sorted labels of all, the beginning and the final states.
+    LabelRange getStateLabels() const;
+    LabelRange getBeginningLabels() const;
+    LabelRange getFinalLabels() const;
+
+    TransitionRange getTransitions() const;
+
+    ///Gets the sorted ids of the patterns accepted by the final states in the set.
+    std::vector<int> getAcceptedPatterns(const std::vector<int>&) const;
+
+    StateRange getBeginningStates() const;
+
+    ///The letter edges of the state are letterEdgesBegin(state) to letterEdgesEnd(state) - 1.
+    std::size_t letterEdgesBegin(int state) const {
+        return array(letterStartOffset)[state];
+    }
+
+    std::size_t letterEdgesEnd(int state) const {
+        return array(letterStartOffset)[state + 1];
+    }
+
+    int getEdgeTarget(std::size_t edge) const {
+        return array(letterTargetOffset)[edge];
+    }
+
+    ///Checks if the letter edge can read the given letter.
+    bool edgeReads(std::size_t edge, char letter) const {
+        return maskContains(array(letterMaskOffset) + edge * MASK_WORDS, letter);
+    }
+
+    ///Gets the letter mask of the edge.
+    const std::uint32_t* getEdgeMask(std::size_t edge) const {
+        return array(letterMaskOffset) + edge * MASK_WORDS;
+    }
+
+    ///Gets the targets of the epsilon transitions of the state.
+    StateRange getEpsilonEdges(int state) const {
+        const std::uint32_t* targets = array(epsilonTargetOffset);
+        return {targets + array(epsilonStartOffset)[state], targets + array(epsilonStartOffset)[state + 1]};
+    }
+
+    ///Checks if some transition reads the letter explicitly (not only through '?').
+    bool isExplicitLetter(char) const;
+
+    ///Checks if the letter is in the mask.
+    static bool maskContains(const std::uint32_t* mask, char letter) {
+        unsigned char byte = letter;
+        return (mask[byte >> 5] >> (byte & 31)) & 1;
+    }
+
+    /** Groups the bytes that every transition reads or skips together.
+     *
+     *  Fills the class of every byte and returns the number of classes. Bytes no transition
+     *  reads explicitly always end up in the same class.
+     *
+     */
+    std::size_t getByteClasses(std::array<std::uint8_t, 256>&) const;
+
+    /** Adds the state and everything reachable from it with epsilon transitions to the set.
+     *
+     *  The stack is scratch space passed in by the caller so that no memory is allocated here.
+     *
+     */
+    void addClosure(SparseSet&, int, std::vector<int>& stack) const;
+
+    ///Adds the closures of all states reached from the first set with the letter to the second set.
+    void step(const SparseSet&, char, SparseSet&, std::vector<int>& stack) const;
+
+    /** Subset construction.
+     *
+     *  The transitions are first grouped by state and byte class, every deterministic state is
+     *  kept as a sorted vector and a hash map finds the id of a set, so every new state costs
+     *  time proportional to the transitions that leave its automaton states.
+     *
+     */
+    DeterministicTable determine() const;
+};
+
+#endif
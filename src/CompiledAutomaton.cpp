@@ -0,0 +1,350 @@
+#include "CompiledAutomaton.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "FileScanner.hpp"
+
+namespace {
+    const char FILE_MAGIC[8] = {'F', 'A', 'U', 'T', 'O', 'M', 'A', 'T'};
+    const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    std::size_t alignSection(std::size_t offset) {
+        return (offset + 7) & ~std::size_t(7);
+    }
+}
+
+CompiledAutomaton::BodyLayout::BodyLayout(std::size_t classCount, std::size_t stateCount, std::size_t patternCount) {
+    table = 256;
+    finalStates = alignSection(table + stateCount * classCount * sizeof(std::uint32_t));
+    patternStarts = alignSection(finalStates + stateCount);
+    patterns = alignSection(patternStarts + (stateCount + 1) * sizeof(std::uint32_t));
+    size = alignSection(patterns + patternCount * sizeof(std::uint32_t));
+}
+
+CompiledAutomaton::CompiledAutomaton(const CompactNfa::DeterministicTable& dfa) {
+    classCount = dfa.classCount;
+    std::size_t acceptedCount = 0;
+    for (const std::vector<int>& accepted : dfa.acceptedPatterns) {
+        acceptedCount += accepted.size();
+    }
+
+    //State 0 is reserved for the dead state, state i of the table becomes i + 1.
+    std::size_t rows = dfa.stateCount() + 1;
+    BodyLayout layout(classCount, rows, acceptedCount);
+    auto buffer = std::make_shared<std::vector<std::uint64_t>>(layout.size / sizeof(std::uint64_t), 0);
+    char* data = reinterpret_cast<char*>(buffer -> data());
+
+    std::memcpy(data, dfa.byteClasses.data(), 256);
+    std::uint32_t* newTable = reinterpret_cast<std::uint32_t*>(data + layout.table);
+    std::uint8_t* newFinalStates = reinterpret_cast<std::uint8_t*>(data + layout.finalStates);
+    std::uint32_t* newPatternStarts = reinterpret_cast<std::uint32_t*>(data + layout.patternStarts);
+    int* newPatterns = reinterpret_cast<int*>(data + layout.patterns);
+
+    std::size_t patternCount = 0;
+    for (std::size_t state = 0; state < dfa.stateCount(); state++) {
+        for (std::uint32_t byteClass = 0; byteClass < classCount; byteClass++) {
+            int target = dfa.table[state * classCount + byteClass];
+            if (target >= 0) newTable[(state + 1) * classCount + byteClass] = target + 1;
+        }
+
+        newFinalStates[state + 1] = dfa.isFinal(state);
+        for (int pattern : dfa.acceptedPatterns[state]) {
+            newPatterns[patternCount++] = pattern;
+        }
+        newPatternStarts[state + 2] = patternCount;
+    }
+
+    states = rows;
+    this -> patternCount = patternCount;
+    beginningState = 1;
+    storage = buffer;
+    attach(data, layout);
+    findRequiredPrefix();
+    findAcceptingSink();
+}
+
+void CompiledAutomaton::attach(const char* data, const BodyLayout& layout) {
+    body = data;
+    std::memcpy(byteClasses.data(), data, 256);
+    table = reinterpret_cast<const std::uint32_t*>(data + layout.table);
+    finalStates = reinterpret_cast<const std::uint8_t*>(data + layout.finalStates);
+    patternStarts = reinterpret_cast<const std::uint32_t*>(data + layout.patternStarts);
+    patterns = reinterpret_cast<const int*>(data + layout.patterns);
+}
+
+std::uint64_t CompiledAutomaton::checksum(const char* data, std::size_t size) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t offset = 0; offset < size; offset++) {
+        hash = (hash ^ (unsigned char) data[offset]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void CompiledAutomaton::save(const std::string& path) const {
+    BodyLayout layout(classCount, states, patternCount);
+
+    FileHeader header = {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.classCount = classCount;
+    header.stateCount = states;
+    header.beginningState = beginningState;
+    header.patternCount = patternCount;
+    header.flags = flags;
+    header.bodySize = layout.size;
+    header.checksum = checksum(body, layout.size);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(body, layout.size);
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Could not write the automaton file!");
+    }
+}
+
+CompiledAutomaton CompiledAutomaton::load(const std::string& path, bool verify) {
+    auto file = std::make_shared<FileScanner>(path);
+    std::string_view contents = file -> getContents();
+
+    FileHeader header;
+    if (contents.size() < sizeof(header)) {
+        throw std::runtime_error("Invalid automaton file!");
+    }
+    std::memcpy(&header, contents.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.byteOrder != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Invalid automaton file!");
+    }
+    if (header.version != FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported automaton file version!");
+    }
+    if (header.classCount == 0 || header.classCount > 256 || header.stateCount == 0 || header.beginningState >= header.stateCount
+        || (header.flags & ~PATTERN_SET_FLAG) != 0 || header.padding != 0) {
+        throw std::runtime_error("Invalid automaton file!");
+    }
+
+    BodyLayout layout(header.classCount, header.stateCount, header.patternCount);
+    const char* data = contents.data() + sizeof(header);
+    if (header.bodySize != layout.size || contents.size() - sizeof(header) != layout.size) {
+        throw std::runtime_error("Invalid automaton file!");
+    }
+    if (reinterpret_cast<std::uintptr_t>(data) % sizeof(std::uint64_t) != 0) {
+        throw std::runtime_error("Misaligned automaton file contents!");
+    }
+
+    CompiledAutomaton automaton;
+    automaton.classCount = header.classCount;
+    automaton.states = header.stateCount;
+    automaton.beginningState = header.beginningState;
+    automaton.patternCount = header.patternCount;
+    automaton.flags = header.flags;
+    automaton.attach(data, layout);
+
+    if (verify) {
+        if (checksum(data, layout.size) != header.checksum) {
+            throw std::runtime_error("Automaton file checksum mismatch!");
+        }
+
+        bool valid = automaton.patternStarts[0] == 0 && automaton.patternStarts[automaton.states] == automaton.patternCount;
+        for (int byte = 0; byte < 256; byte++) {
+            valid = valid && automaton.byteClasses[byte] < automaton.classCount;
+        }
+        for (std::size_t i = 0; i < (std::size_t) automaton.states * automaton.classCount; i++) {
+            valid = valid && automaton.table[i] < automaton.states;
+        }
+        for (std::uint32_t state = 0; state < automaton.states; state++) {
+            valid = valid && automaton.patternStarts[state] <= automaton.patternStarts[state + 1];
+        }
+        //The ids of every state are sorted and not negative, like those made by determine().
+        for (std::uint32_t state = 0; valid && state < automaton.states; state++) {
+            for (std::uint32_t i = automaton.patternStarts[state]; i < automaton.patternStarts[state + 1]; i++) {
+                valid = valid && automaton.patterns[i] >= 0 && (i == automaton.patternStarts[state] || automaton.patterns[i - 1] < automaton.patterns[i]);
+            }
+        }
+        if (!valid) {
+            throw std::runtime_error("Invalid automaton file!");
+        }
+    }
+
+    automaton.storage = file;
+    automaton.findRequiredPrefix();
+    automaton.findAcceptingSink();
+    return automaton;
+}
+
+void CompiledAutomaton::findRequiredPrefix() {
+    std::vector<int> classSizes(classCount, 0);
+    std::array<char, 256> classLetters{};
+    for (int byte = 0; byte < 256; byte++) {
+        classSizes[byteClasses[byte]]++;
+        classLetters[byteClasses[byte]] = (char) byte;
+    }
+
+    std::vector<bool> visited(stateCount(), false);
+    std::uint32_t current = beginningState;
+
+    while (current != DEAD_STATE && !finalStates[current] && !visited[current]) {
+        visited[current] = true;
+
+        std::uint32_t liveClass = classCount;
+        for (std::uint32_t byteClass = 0; byteClass < classCount; byteClass++) {
+            if (table[current * classCount + byteClass] == DEAD_STATE) continue;
+            if (liveClass != classCount || classSizes[byteClass] != 1) return;
+            liveClass = byteClass;
+        }
+        if (liveClass == classCount) return;
+
+        requiredPrefix.push_back(classLetters[liveClass]);
+        current = table[current * classCount + liveClass];
+    }
+}
+
+void CompiledAutomaton::findAcceptingSink() {
+    for (std::uint32_t state = DEAD_STATE + 1; state < states; state++) {
+        if (!finalStates[state]) continue;
+
+        const std::uint32_t* row = table + state * classCount;
+        if (std::all_of(row, row + classCount, [&](std::uint32_t target) { return target == state; })) {
+            acceptingSink = state;
+            return;
+        }
+    }
+}
+
+bool CompiledAutomaton::match(std::string_view word) const {
+    std::uint32_t current = beginningState;
+
+    for (char c : word) {
+        if (isSink(current)) break;
+        current = table[current * classCount + byteClasses[(unsigned char) c]];
+    }
+
+    return finalStates[current];
+}
+
+void CompiledAutomaton::matchBatch(const std::string_view* words, std::size_t count, std::uint64_t* results) const {
+    std::fill(results, results + (count + 63) / 64, std::uint64_t(0));
+
+    //The bits of one block of 64 words are collected here, so they are not stored one by one.
+    std::size_t block = 0;
+    std::uint64_t bits = 0;
+    auto endWord = [&](std::size_t word, std::uint32_t state) {
+        if (word / 64 != block) {
+            results[block] |= bits;
+            block = word / 64;
+            bits = 0;
+        }
+        bits |= std::uint64_t(finalStates[state]) << (word % 64);
+    };
+
+    //Every lane walks one word and takes the next one when it is done.
+    const unsigned char* position[BATCH_LANES];
+    std::size_t remaining[BATCH_LANES];
+    std::uint32_t state[BATCH_LANES];
+    std::size_t word[BATCH_LANES];
+    bool busy[BATCH_LANES] = {};
+
+    //Most short words end or die within their first letters, which is cheaper to find out one
+    //word at a time. Only the words that are still alive after that take a lane.
+    std::size_t next = 0;
+    auto startWord = [&](std::size_t lane) {
+        for (; next < count; next++) {
+            const unsigned char* letters = reinterpret_cast<const unsigned char*>(words[next].data());
+            std::size_t size = words[next].size();
+            std::size_t prefix = std::min(size, BATCH_PREFIX);
+
+            std::uint32_t current = beginningState;
+            for (std::size_t i = 0; i < prefix && !isSink(current); i++) {
+                current = table[current * classCount + byteClasses[letters[i]]];
+            }
+
+            if (prefix == size || isSink(current)) {
+                endWord(next, current);
+                continue;
+            }
+
+            position[lane] = letters + prefix;
+            remaining[lane] = size - prefix;
+            state[lane] = current;
+            word[lane] = next++;
+            return true;
+        }
+        return false;
+    };
+
+    std::size_t busyLanes = 0;
+    while (busyLanes < BATCH_LANES && startWord(busyLanes)) {
+        busy[busyLanes++] = true;
+    }
+
+    while (busyLanes == BATCH_LANES) {
+        //Every lane can take as many steps as the shortest word has left without any checks.
+        std::size_t steps = remaining[0];
+        for (std::size_t lane = 1; lane < BATCH_LANES; lane++) {
+            steps = std::min(steps, remaining[lane]);
+        }
+
+        for (std::size_t step = 0; step < steps; step++) {
+            for (std::size_t lane = 0; lane < BATCH_LANES; lane++) {
+                state[lane] = table[state[lane] * classCount + byteClasses[position[lane][step]]];
+            }
+        }
+
+        for (std::size_t lane = 0; lane < BATCH_LANES; lane++) {
+            position[lane] += steps;
+            remaining[lane] -= steps;
+            if (remaining[lane] != 0 && !isSink(state[lane])) continue;
+
+            endWord(word[lane], state[lane]);
+            if (!startWord(lane)) {
+                busy[lane] = false;
+                busyLanes--;
+            }
+        }
+    }
+
+    //There are no words left to fill the lanes, the rest of the last ones is walked one by one.
+    for (std::size_t lane = 0; lane < BATCH_LANES; lane++) {
+        if (!busy[lane]) continue;
+
+        for (; remaining[lane] > 0 && !isSink(state[lane]); remaining[lane]--) {
+            state[lane] = table[state[lane] * classCount + byteClasses[*position[lane]++]];
+        }
+        endWord(word[lane], state[lane]);
+    }
+
+    if (count > 0) results[block] |= bits;
+}
+
+std::vector<std::uint64_t> CompiledAutomaton::matchBatch(const std::vector<std::string_view>& words) const {
+    std::vector<std::uint64_t> results((words.size() + 63) / 64);
+    matchBatch(words.data(), words.size(), results.data());
+    return results;
+}
+
+CompiledAutomaton::PatternRange CompiledAutomaton::matchPatterns(std::string_view word) const {
+    std::uint32_t current = beginningState;
+
+    for (char c : word) {
+        if (isSink(current)) break;
+        current = table[current * classCount + byteClasses[(unsigned char) c]];
+    }
+
+    return {patterns + patternStarts[current], patterns + patternStarts[current + 1]};
+}
+
+const std::string& CompiledAutomaton::getRequiredPrefix() const {
+    return requiredPrefix;
+}
+
+std::size_t CompiledAutomaton::stateCount() const {
+    return states;
+}
+
+std::size_t CompiledAutomaton::byteClassCount() const {
+    return classCount;
+}
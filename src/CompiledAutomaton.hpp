@@ -0,0 +1,245 @@
+#ifndef __COMPILED_AUTOMATON_HPP_
+#define __COMPILED_AUTOMATON_HPP_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CompactNfa.hpp"
+
+/** Immutable deterministic automaton produced by Automaton::compile().
+ *
+ *  The subset construction is done once when the object is created,
+ *  so match() only walks the transition table.
+ *
+ *  Bytes that behave the same way in every state share a byte class. The transitions are kept
+ *  in one contiguous table indexed by state * classCount + byteClass, so every step of the
+ *  walk is a single indexed load.
+ *
+ *  The tables are kept in one block laid out exactly like the body of the binary format, so
+ *  save() writes it as it is and load() uses a memory-mapped file in place. Copies of the
+ *  automaton share the block.
+ *
+ *  The format is a 56-byte header followed by the body:
+ *
+ *      header:  magic "FAUTOMAT", version, byte order mark 0x01020304, classCount,
+ *               stateCount, beginningState, patternCount, flags, padding (all 32-bit),
+ *               bodySize, checksum (64-bit)
+ *      body:    byteClasses[256] (8-bit), table[stateCount * classCount] (32-bit),
+ *               finalStates[stateCount] (8-bit), patternStarts[stateCount + 1] (32-bit),
+ *               patterns[patternCount] (32-bit)
+ *
+ *  Bit 0 of flags is set for an automaton compiled by PatternSet, the other bits are zero.
+ *  The padding word keeps bodySize at offset 40 and is zero. Every body section starts at a
+ *  multiple of 8 bytes and the padding is zero. The checksum is 64-bit FNV-1a over the bytes
+ *  of the body. Numbers are stored in the byte order of the machine that wrote the file, a
+ *  file with the other order is rejected.
+ *
+ */
+class CompiledAutomaton {
+public:
+    ///The dead state. Every missing transition leads to it and it never leaves itself.
+    static constexpr std::uint32_t DEAD_STATE = 0;
+
+    ///The ids of the patterns accepted in a state.
+    struct PatternRange {
+        const int* first;
+        const int* last;
+
+        const int* begin() const { return first; }
+        const int* end() const { return last; }
+        std::size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+    ///Version of the binary format written by save().
+    static constexpr std::uint32_t FORMAT_VERSION = 1;
+
+    ///Number of words matchBatch() walks at the same time.
+    static constexpr std::size_t BATCH_LANES = 8;
+
+    ///Number of letters matchBatch() reads from every word on its own before it gives it a lane.
+    static constexpr std::size_t BATCH_PREFIX = 8;
+
+private:
+    ///Header of the binary format.
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint32_t classCount;
+        std::uint32_t stateCount;
+        std::uint32_t beginningState;
+        std::uint32_t patternCount;
+        std::uint32_t flags;
+        std::uint32_t padding;
+        std::uint64_t bodySize;
+        std::uint64_t checksum;
+    };
+    static_assert(sizeof(FileHeader) == 56, "FileHeader must not have implicit padding");
+
+    ///Flag of an automaton compiled by PatternSet.
+    static constexpr std::uint32_t PATTERN_SET_FLAG = 1;
+
+    ///Offsets of the body sections in bytes.
+    struct BodyLayout {
+        std::size_t table, finalStates, patternStarts, patterns, size;
+
+        BodyLayout(std::size_t classCount, std::size_t stateCount, std::size_t patternCount);
+    };
+
+    ///Maps every byte to its equivalence class.
+    std::array<std::uint8_t, 256> byteClasses{};
+
+    ///Number of byte classes (the width of a table row).
+    std::uint32_t classCount = 1;
+
+    ///The transition table, one row of classCount entries per state.
+    const std::uint32_t* table = nullptr;
+
+    ///Whether every state is final.
+    const std::uint8_t* finalStates = nullptr;
+
+    ///Number of states (including the dead state).
+    std::uint32_t states = 0;
+
+    ///The beginning state.
+    std::uint32_t beginningState = DEAD_STATE;
+
+    ///The accepted patterns of state i are patterns[patternStarts[i]] to patterns[patternStarts[i + 1]].
+    const std::uint32_t* patternStarts = nullptr;
+
+    ///The accepted patterns of all states.
+    const int* patterns = nullptr;
+
+    ///Number of entries in patterns.
+    std::uint32_t patternCount = 0;
+
+    ///The flags stored in the header.
+    std::uint32_t flags = 0;
+
+    ///The body the pointers above point into.
+    const char* body = nullptr;
+
+    ///Owns the body (a buffer or a mapped file).
+    std::shared_ptr<const void> storage;
+
+    ///The literal every recognized word starts with.
+    std::string requiredPrefix;
+
+    /** A final state that only leads to itself, or the dead state if there is none.
+     * 
+     *  Every word that reaches it is recognized whatever follows, so matching stops there
+     *  just like at the dead state. Complements have one when their sink is reachable.
+     * 
+     */
+    std::uint32_t acceptingSink = DEAD_STATE;
+
+    ///Finds the literal every recognized word starts with.
+    void findRequiredPrefix();
+
+    ///Finds a final state that only leads to itself.
+    void findAcceptingSink();
+
+    ///Points the tables into the body.
+    void attach(const char*, const BodyLayout&);
+
+    ///Computes the checksum of the body.
+    static std::uint64_t checksum(const char*, std::size_t);
+
+    CompiledAutomaton() = default;
+
+    ///Builds the table from the result of the subset construction.
+    explicit CompiledAutomaton(const CompactNfa::DeterministicTable&);
+
+    friend class Automaton;
+    friend class PatternSet;
+    friend class SearchAutomaton;
+
+public:
+    ///Checks if the automaton recognizes the given word
+    bool match(std::string_view) const;
+
+    /** Checks which of the words the automaton recognizes.
+     * 
+     *  Bit i % 64 of results[i / 64] is set if the i-th word is recognized, results must have
+     *  room for (count + 63) / 64 numbers. Words still alive after their first BATCH_PREFIX
+     *  letters are walked BATCH_LANES at a time, one letter of each in turn, so the table loads
+     *  of different words overlap instead of every load waiting for the previous one. This
+     *  pays off for long words and for tables that do not fit in the cache.
+     * 
+     */
+    void matchBatch(const std::string_view*, std::size_t, std::uint64_t*) const;
+
+    ///Same as above, returns the bits.
+    std::vector<std::uint64_t> matchBatch(const std::vector<std::string_view>&) const;
+
+    /** Gets the ids of all patterns that recognize the given word.
+     * 
+     *  An automaton compiled from a single pattern reports pattern 0. The range points into
+     *  the automaton, so it is valid as long as the automaton is.
+     * 
+     */
+    PatternRange matchPatterns(std::string_view) const;
+
+    /** Gets the literal every recognized word starts with.
+     * 
+     *  It is followed from the beginning state for as long as only one letter leads to a live
+     *  state. Scanners can skip every record that does not start with it without matching it.
+     * 
+     */
+    const std::string& getRequiredPrefix() const;
+
+    ///Gets the beginning state, to walk the table one byte at a time with next().
+    std::uint32_t getBeginningState() const {
+        return beginningState;
+    }
+
+    ///Gets the state reached from the state by reading the letter. The dead state only reaches itself.
+    std::uint32_t next(std::uint32_t state, char letter) const {
+        return table[state * classCount + byteClasses[(unsigned char) letter]];
+    }
+
+    bool isFinal(std::uint32_t state) const {
+        return finalStates[state];
+    }
+
+    ///Checks if the state only leads to itself (the dead state or the accepting sink), so reading more letters changes nothing.
+    bool isSink(std::uint32_t state) const {
+        return state == DEAD_STATE || state == acceptingSink;
+    }
+
+    /** Checks if the automaton was compiled by PatternSet.
+     * 
+     *  Its matches are told apart by the ids of their patterns, so they should be reported
+     *  with matchPatterns(). The flag is saved with the automaton.
+     * 
+     */
+    bool isPatternSet() const {
+        return flags & PATTERN_SET_FLAG;
+    }
+
+    ///Gets the number of states in the table (including the dead state).
+    std::size_t stateCount() const;
+
+    ///Gets the number of byte classes.
+    std::size_t byteClassCount() const;
+
+    ///Writes the automaton to the file in the binary format. Throws std::runtime_error on failure.
+    void save(const std::string&) const;
+
+    /** Loads an automaton written by save().
+     * 
+     *  Regular files are memory-mapped and used in place, nothing is allocated per state. With
+     *  verify set, the checksum is checked, every state and pattern index is checked to be in
+     *  range and the pattern ids of every state to be sorted and not negative, which reads the
+     *  whole file once. Without it only the header is checked, so the file has to be trusted.
+     *  Throws std::runtime_error if the file is not valid.
+     * 
+     */
+    static CompiledAutomaton load(const std::string&, bool verify = true);
+};
+
+#endif
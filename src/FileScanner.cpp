@@ -0,0 +1,90 @@
+#include "FileScanner.hpp"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileScanner::FileScanner(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Invalid file path!");
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* contents = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (contents != MAP_FAILED) {
+            mapping = contents;
+            mappingSize = info.st_size;
+            madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+        }
+    }
+
+    if (mapping == nullptr) {
+        try {
+            readAll(fd);
+        }
+        catch (...) {
+            close(fd);
+            throw;
+        }
+    }
+
+    close(fd);
+}
+
+FileScanner::~FileScanner() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+}
+
+void FileScanner::readAll(int fd) {
+    const std::size_t blockSize = 1 << 20;
+
+    std::size_t size = 0;
+    while (true) {
+        buffer.resize(size + blockSize);
+        ssize_t count = read(fd, &buffer[size], blockSize);
+        if (count < 0) {
+            throw std::runtime_error("Could not read the file!");
+        }
+        if (count == 0) break;
+        size += count;
+    }
+    buffer.resize(size);
+}
+
+std::string_view FileScanner::getContents() const {
+    if (mapping != nullptr) {
+        return std::string_view(static_cast<const char*>(mapping), mappingSize);
+    }
+    return buffer;
+}
+
+std::vector<std::string_view> FileScanner::splitIntoChunks(std::string_view text, RecordMode mode, std::size_t count) {
+    std::vector<std::string_view> chunks;
+    if (count == 0) count = 1;
+
+    std::size_t begin = 0;
+    for (std::size_t i = 1; i <= count && begin < text.size(); i++) {
+        std::size_t end = i == count ? text.size() : std::max(begin, text.size() / count * i);
+
+        //Moves the end right after the next record separator.
+        if (mode == lines) {
+            std::size_t newLine = text.find('\n', end);
+            end = newLine == std::string_view::npos ? text.size() : newLine + 1;
+        }
+        else {
+            while (end < text.size() && !isWhitespace(text[end])) end++;
+        }
+
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+
+    return chunks;
+}
@@ -0,0 +1,193 @@
+#ifndef __FILE_SCANNER_HPP_
+#define __FILE_SCANNER_HPP_
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "LiteralSearch.hpp"
+
+/** Gives the contents of a file as records without copying them.
+ *
+ *  Regular files are memory-mapped. Anything that cannot be mapped (pipes, character devices)
+ *  is read in large blocks into a single buffer. The records are string_view slices of the
+ *  contents, so scanning them allocates nothing.
+ *
+ */
+class FileScanner {
+public:
+    ///How the contents are split into records.
+    enum RecordMode {words, lines};
+
+private:
+    ///The mapped contents (or nullptr if the file was read into buffer).
+    void* mapping = nullptr;
+
+    ///Size of the mapped contents.
+    std::size_t mappingSize = 0;
+
+    ///The contents of a file that could not be mapped.
+    std::string buffer;
+
+    ///Reads the whole file into the buffer.
+    void readAll(int);
+
+public:
+    ///Checks if the character separates words.
+    static bool isWhitespace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    explicit FileScanner(const std::string&);
+    FileScanner(const FileScanner&) = delete;
+    FileScanner& operator = (const FileScanner&) = delete;
+    ~FileScanner();
+
+    ///Gets the whole contents of the file.
+    std::string_view getContents() const;
+
+    /** Calls the callback with every record of the text.
+     *
+     *  Words are separated by any whitespace and empty words are skipped. Lines are separated by
+     *  '\n', a trailing '\r' is dropped and the empty record after the last '\n' is skipped.
+     *
+     */
+    template <typename Callback>
+    static void forEachRecord(std::string_view, RecordMode, Callback&&);
+
+    ///Calls the callback with every record of the file.
+    template <typename Callback>
+    void forEachRecord(RecordMode mode, Callback&& callback) const {
+        forEachRecord(getContents(), mode, callback);
+    }
+
+    /** Calls the callback with every record of the text that starts with the prefix.
+     *
+     *  Jumps between the occurrences of the prefix with LiteralSearch::find(), so the records
+     *  in between are never looked at. With an empty prefix it is the same as forEachRecord().
+     *
+     */
+    template <typename Callback>
+    static void forEachRecordWithPrefix(std::string_view, RecordMode, std::string_view, Callback&&);
+
+    /** Splits the text into at most the given number of chunks of about the same size.
+     *
+     *  Every chunk ends on a record boundary, so splitting the chunks into records gives the
+     *  same records as splitting the whole text.
+     *
+     */
+    static std::vector<std::string_view> splitIntoChunks(std::string_view, RecordMode, std::size_t);
+
+    /** Finds the records of the file recognized by the matcher using several threads.
+     *
+     *  The file is split into chunks on record boundaries and the threads take chunks one by
+     *  one. The matcher is shared between the threads, so its match() has to be const.
+     *  Only records starting with the prefix are matched. The matched records are returned in
+     *  input order.
+     *
+     */
+    template <typename Matcher>
+    std::vector<std::string_view> findMatches(RecordMode, const Matcher&, std::size_t, std::string_view = "") const;
+};
+
+template <typename Callback>
+void FileScanner::forEachRecord(std::string_view text, RecordMode mode, Callback&& callback) {
+    const char* current = text.data();
+    const char* end = text.data() + text.size();
+
+    if (mode == lines) {
+        while (current < end) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(current, '\n', end - current));
+            if (lineEnd == nullptr) lineEnd = end;
+
+            const char* recordEnd = lineEnd;
+            if (recordEnd > current && recordEnd[-1] == '\r') recordEnd--;
+            callback(std::string_view(current, recordEnd - current));
+
+            current = lineEnd + 1;
+        }
+    }
+    else {
+        while (current < end) {
+            while (current < end && isWhitespace(*current)) current++;
+
+            const char* wordEnd = current;
+            while (wordEnd < end && !isWhitespace(*wordEnd)) wordEnd++;
+
+            if (wordEnd > current) callback(std::string_view(current, wordEnd - current));
+            current = wordEnd;
+        }
+    }
+}
+
+template <typename Callback>
+void FileScanner::forEachRecordWithPrefix(std::string_view text, RecordMode mode, std::string_view prefix, Callback&& callback) {
+    if (prefix.empty()) {
+        forEachRecord(text, mode, callback);
+        return;
+    }
+
+    const char* current = text.data();
+    const char* end = text.data() + text.size();
+
+    while ((current = LiteralSearch::find(current, end, prefix)) != nullptr) {
+        bool recordStart = current == text.data() || (mode == lines ? current[-1] == '\n' : isWhitespace(current[-1]));
+        if (!recordStart) {
+            current++;
+            continue;
+        }
+
+        const char* recordEnd = current;
+        if (mode == lines) {
+            recordEnd = static_cast<const char*>(std::memchr(current, '\n', end - current));
+            if (recordEnd == nullptr) recordEnd = end;
+
+            const char* next = recordEnd;
+            if (recordEnd > current && recordEnd[-1] == '\r') recordEnd--;
+            callback(std::string_view(current, recordEnd - current));
+            current = next;
+        }
+        else {
+            while (recordEnd < end && !isWhitespace(*recordEnd)) recordEnd++;
+            callback(std::string_view(current, recordEnd - current));
+            current = recordEnd;
+        }
+    }
+}
+
+template <typename Matcher>
+std::vector<std::string_view> FileScanner::findMatches(RecordMode mode, const Matcher& matcher, std::size_t threadCount, std::string_view prefix) const {
+    if (threadCount == 0) threadCount = 1;
+
+    //More chunks than threads, so that a thread that is done early can take another one.
+    std::vector<std::string_view> chunks = splitIntoChunks(getContents(), mode, threadCount * 8);
+    std::vector<std::vector<std::string_view>> chunkMatches(chunks.size());
+    std::atomic<std::size_t> nextChunk(0);
+
+    auto worker = [&]() {
+        for (std::size_t chunk = nextChunk++; chunk < chunks.size(); chunk = nextChunk++) {
+            forEachRecordWithPrefix(chunks[chunk], mode, prefix, [&](std::string_view record) {
+                if (matcher.match(record)) chunkMatches[chunk].push_back(record);
+            });
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<std::string_view> matches;
+    for (std::vector<std::string_view>& found : chunkMatches) {
+        matches.insert(matches.end(), found.begin(), found.end());
+    }
+    return matches;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include "LazyDfa.hpp"
+
+#include <algorithm>
+#include <utility>
+#include "Automaton.hpp"
+
+LazyDfa::LazyDfa(const Automaton& automaton, std::size_t cacheLimit) 
+    : nfa(*automaton.getCompactNfa()), cacheLimit(cacheLimit), current(nfa.stateCount()), next(nfa.stateCount()) {
+
+    classCount = nfa.getByteClasses(byteClasses);
+
+    //The dead and the beginning state are always added, whatever the limit is.
+    persistentStates = 2;
+
+    std::vector<int> deadState;
+    addState(deadState);
+
+    for (int state : nfa.getBeginningStates()) {
+        nfa.addClosure(current, state, stack);
+    }
+    std::vector<int> beginningSet(current.begin(), current.end());
+    std::sort(beginningSet.begin(), beginningSet.end());
+    beginningState = addState(beginningSet);
+
+    persistentStates = stateSets.size();
+}
+
+std::size_t LazyDfa::stateCost(std::size_t setSize) const {
+    //The set itself, its table row and roughly the hash map node around it.
+    return setSize * sizeof(int) + classCount * sizeof(std::uint32_t) + sizeof(std::vector<int>) + 4 * sizeof(void*);
+}
+
+std::uint32_t LazyDfa::addState(std::vector<int>& states) {
+    auto found = ids.find(states);
+    if (found != ids.end()) return found -> second;
+
+    std::size_t cost = stateCost(states.size());
+    if (cacheSize + cost > cacheLimit && stateSets.size() > persistentStates) return UNKNOWN;
+
+    std::uint32_t id = stateSets.size();
+    bool final = false;
+    for (int state : states) {
+        if (nfa.isFinal(state)) final = true;
+    }
+
+    table.resize(table.size() + classCount, states.empty() ? DEAD_STATE : UNKNOWN);
+    finalStates.push_back(final);
+    stateSets.push_back(&ids.emplace(std::move(states), id).first -> first);
+    cacheSize += cost;
+
+    return id;
+}
+
+void LazyDfa::flush() {
+    std::vector<std::vector<int>> kept;
+    for (std::size_t i = 0; i < persistentStates; i++) {
+        kept.push_back(*stateSets[i]);
+    }
+
+    ids.clear();
+    stateSets.clear();
+    finalStates.clear();
+    table.clear();
+    cacheSize = 0;
+
+    for (std::vector<int>& states : kept) {
+        addState(states);
+    }
+
+    flushes++;
+    lettersSinceFlush = 0;
+}
+
+std::uint32_t LazyDfa::computeTransition(std::uint32_t state, char letter) {
+    current.clear();
+    for (int nfaState : *stateSets[state]) {
+        current.insert(nfaState);
+    }
+
+    next.clear();
+    nfa.step(current, letter, next, stack);
+
+    std::vector<int> target(next.begin(), next.end());
+    std::sort(target.begin(), target.end());
+
+    std::uint32_t id = addState(target);
+    if (id == UNKNOWN) {
+        //The cache did not pay off since the last flush, flushing again would not help either.
+        if (lettersSinceFlush < 10 * stateSets.size()) return UNKNOWN;
+
+        flush();
+        id = addState(target);
+        if (state >= persistentStates) return id;
+    }
+
+    table[state * classCount + byteClasses[(unsigned char) letter]] = id;
+    return id;
+}
+
+bool LazyDfa::simulate(std::uint32_t state, std::string_view rest) {
+    current.clear();
+    for (int nfaState : *stateSets[state]) {
+        current.insert(nfaState);
+    }
+
+    for (char c : rest) {
+        if (current.empty()) return false;
+
+        next.clear();
+        nfa.step(current, c, next, stack);
+        std::swap(current, next);
+    }
+
+    for (int nfaState : current) {
+        if (nfa.isFinal(nfaState)) return true;
+    }
+    return false;
+}
+
+bool LazyDfa::match(std::string_view word) {
+    std::uint32_t state = beginningState;
+
+    for (std::size_t i = 0; i < word.size(); i++) {
+        if (state == DEAD_STATE) return false;
+
+        std::uint32_t nextState = table[state * classCount + byteClasses[(unsigned char) word[i]]];
+        if (nextState == UNKNOWN) {
+            nextState = computeTransition(state, word[i]);
+            if (nextState == UNKNOWN) return simulate(state, word.substr(i));
+        }
+
+        state = nextState;
+        lettersSinceFlush++;
+    }
+
+    return finalStates[state];
+}
+
+std::size_t LazyDfa::stateCount() const {
+    return stateSets.size();
+}
+
+std::size_t LazyDfa::flushCount() const {
+    return flushes;
+}
@@ -0,0 +1,109 @@
+#ifndef __LAZY_DFA_HPP_
+#define __LAZY_DFA_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "CompactNfa.hpp"
+
+/** Deterministic automaton that is built while it is being used.
+ *
+ *  A deterministic state (a set of automaton states) is created only when the input first
+ *  reaches it, and its transitions are filled in the same way. The states live in a cache with
+ *  a memory limit. When the limit is reached the cache is flushed, and if it keeps getting
+ *  flushed faster than it pays off, the rest of the word is matched with NFA simulation.
+ *
+ *  The cost of creating the matcher and the memory it uses depend on the input that was
+ *  actually matched, not on the worst case number of deterministic states.
+ *
+ */
+class LazyDfa {
+public:
+    ///Default memory limit of the state cache in bytes.
+    static constexpr std::size_t DEFAULT_CACHE_LIMIT = 8 << 20;
+
+private:
+    ///The dead state. It is never flushed.
+    static constexpr std::uint32_t DEAD_STATE = 0;
+
+    ///Marks a transition that has not been computed yet.
+    static constexpr std::uint32_t UNKNOWN = UINT32_MAX;
+
+    CompactNfa nfa;
+
+    ///Maps every byte to its equivalence class.
+    std::array<std::uint8_t, 256> byteClasses{};
+
+    ///Number of byte classes (the width of a table row).
+    std::uint32_t classCount = 1;
+
+    ///The automaton states of every cached state, sorted. Points to the keys of ids.
+    std::vector<const std::vector<int>*> stateSets;
+
+    ///Whether every cached state is final.
+    std::vector<std::uint8_t> finalStates;
+
+    ///The known transitions, one row of classCount entries per cached state.
+    std::vector<std::uint32_t> table;
+
+    ///Maps a set of automaton states to its cached state.
+    std::unordered_map<std::vector<int>, std::uint32_t, CompactNfa::StateSetHash> ids;
+
+    ///The beginning state.
+    std::uint32_t beginningState = DEAD_STATE;
+
+    ///Number of states that are never flushed (the dead and the beginning state).
+    std::size_t persistentStates = 0;
+
+    ///Approximate memory used by the cache in bytes.
+    std::size_t cacheSize = 0;
+
+    ///The memory limit of the cache in bytes.
+    std::size_t cacheLimit;
+
+    ///Number of flushes since the matcher was created.
+    std::size_t flushes = 0;
+
+    ///Letters matched since the last flush.
+    std::size_t lettersSinceFlush = 0;
+
+    ///Scratch space for the transition computation.
+    SparseSet current, next;
+    std::vector<int> stack;
+
+    ///Gets the cached state of the set, adding it if needed. Returns UNKNOWN if the cache is full.
+    std::uint32_t addState(std::vector<int>&);
+
+    ///Gets the approximate memory needed for a cached state.
+    std::size_t stateCost(std::size_t) const;
+
+    ///Drops every cached state except the dead and the beginning state.
+    void flush();
+
+    /** Computes the transition of the state with the letter.
+     * 
+     *  Returns UNKNOWN if the cache keeps filling up and the caller should fall back to
+     *  NFA simulation.
+     * 
+     */
+    std::uint32_t computeTransition(std::uint32_t, char);
+
+    ///Matches the rest of the word with NFA simulation starting from the given state.
+    bool simulate(std::uint32_t, std::string_view);
+
+public:
+    explicit LazyDfa(const Automaton&, std::size_t = DEFAULT_CACHE_LIMIT);
+
+    ///Checks if the automaton recognizes the given word
+    bool match(std::string_view);
+
+    ///Gets the number of cached states (including the dead state).
+    std::size_t stateCount() const;
+
+    ///Gets the number of times the cache was flushed.
+    std::size_t flushCount() const;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "LiteralSearch.hpp"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const char* LiteralSearch::find(const char* begin, const char* end, std::string_view literal) {
+    std::size_t length = literal.size();
+    if (length == 0) return begin;
+    if ((std::size_t) (end - begin) < length) return nullptr;
+    if (length == 1) return static_cast<const char*>(std::memchr(begin, literal[0], end - begin));
+
+    const char* current = begin;
+
+#ifdef __SSE2__
+    const __m128i firstLetter = _mm_set1_epi8(literal[0]);
+    const __m128i lastLetter = _mm_set1_epi8(literal[length - 1]);
+
+    //The last block has to start early enough for its copy shifted by length - 1 to stay in range.
+    for (; current + 16 + length - 1 <= end; current += 16) {
+        __m128i firstBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+        __m128i lastBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + length - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstBlock, firstLetter), _mm_cmpeq_epi8(lastBlock, lastLetter)));
+
+        while (mask != 0) {
+            int offset = __builtin_ctz(mask);
+            if (std::memcmp(current + offset + 1, literal.data() + 1, length - 2) == 0) return current + offset;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    return static_cast<const char*>(memmem(current, end - current, literal.data(), length));
+}
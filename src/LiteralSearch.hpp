@@ -0,0 +1,17 @@
+#ifndef __LITERAL_SEARCH_HPP_
+#define __LITERAL_SEARCH_HPP_
+
+#include <string_view>
+
+namespace LiteralSearch {
+    /** Finds the first occurrence of the literal in the range [begin, end).
+     *
+     *  Compares the first and the last letter of the literal against 16 positions at once with
+     *  SSE2 and checks the rest only where both of them match. Returns nullptr if there is no
+     *  occurrence.
+     *
+     */
+    const char* find(const char*, const char*, std::string_view);
+}
+
+#endif
@@ -0,0 +1,31 @@
+#include "NfaSimulator.hpp"
+
+#include <utility>
+#include "Automaton.hpp"
+
+NfaSimulator::NfaSimulator(const Automaton& automaton) : snapshot(automaton.getCompactNfa()) {
+
+}
+
+bool NfaSimulator::match(std::string_view word) const {
+    const CompactNfa& nfa = *snapshot;
+    SparseSet current(nfa.stateCount()), next(nfa.stateCount());
+    std::vector<int> stack;
+
+    for (int beginningState : nfa.getBeginningStates()) {
+        nfa.addClosure(current, beginningState, stack);
+    }
+
+    for (char c : word) {
+        if (current.empty()) return false;
+
+        next.clear();
+        nfa.step(current, c, next, stack);
+        std::swap(current, next);
+    }
+
+    for (int state : current) {
+        if (nfa.isFinal(state)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,28 @@
+#ifndef __NFA_SIMULATOR_HPP_
+#define __NFA_SIMULATOR_HPP_
+
+#include <memory>
+#include <string_view>
+#include "CompactNfa.hpp"
+
+/** Matches words directly on the nondeterministic automaton.
+ *
+ *  All active states are advanced together, one letter at a time, and the epsilon closure of
+ *  every newly reached state is added as it is reached. Every state is visited at most once per
+ *  letter, so a word of length n is matched in O(n * m) for an automaton with m transitions,
+ *  without paying for determinization.
+ *
+ */
+class NfaSimulator {
+private:
+    ///The states and transitions of the automaton, shared with it.
+    std::shared_ptr<const CompactNfa> snapshot;
+
+public:
+    explicit NfaSimulator(const Automaton&);
+
+    ///Checks if the automaton recognizes the given word
+    bool match(std::string_view) const;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "PatternSet.hpp"
+
+int PatternSet::add(const std::string& regex) {
+    Automaton automaton;
+    automaton.readRegex(regex);
+    return add(automaton);
+}
+
+int PatternSet::add(const Automaton& automaton) {
+    patterns.push_back(automaton);
+    return patterns.size() - 1;
+}
+
+std::size_t PatternSet::size() const {
+    return patterns.size();
+}
+
+CompiledAutomaton PatternSet::compile(bool minimized) const {
+    //The states of every pattern are moved after those of the previous one, the offsets are computed once.
+    std::vector<int> offsets(patterns.size(), 0);
+    std::size_t stateCount = 1, letterCount = 0;
+    int next = 1;
+    for (std::size_t id = 0; id < patterns.size(); id++) {
+        const Automaton& pattern = patterns[id];
+        if (pattern.getStates().empty()) continue;
+
+        offsets[id] = next - *pattern.getStates().begin();
+        next += *pattern.getStates().rbegin() - *pattern.getStates().begin() + 1;
+
+        stateCount += pattern.getStates().size();
+        letterCount += pattern.getBeginningStates().size();
+        for (auto& transition : pattern.getTransitions()) {
+            letterCount += transition.second.size();
+        }
+    }
+
+    //One new beginning state leads to the beginning states of all patterns.
+    Automaton::Builder builder;
+    builder.reserve(stateCount, letterCount);
+    int beginning = next;
+    builder.addState(beginning, true);
+
+    std::map<int, int> finalPatterns;
+    for (std::size_t id = 0; id < patterns.size(); id++) {
+        const Automaton& pattern = patterns[id];
+        int offset = offsets[id];
+
+        for (int state : pattern.getStates()) {
+            bool final = pattern.getFinalStates().count(state) != 0;
+            builder.addState(state + offset, false, final);
+            if (final) finalPatterns.emplace_hint(finalPatterns.end(), state + offset, id);
+        }
+        for (int beginningState : pattern.getBeginningStates()) {
+            builder.addTransition(std::make_pair(beginning, beginningState + offset), EPSILON);
+        }
+        for (auto& transition : pattern.getTransitions()) {
+            for (char letter : transition.second) {
+                builder.addTransition(std::make_pair(transition.first.first + offset, transition.first.second + offset), letter);
+            }
+        }
+    }
+    Automaton joined = builder.finalize();
+
+    CompactNfa::DeterministicTable dfa = CompactNfa(joined, finalPatterns).determine();
+    if (minimized) {
+        dfa.minimize();
+    }
+
+    CompiledAutomaton compiled(dfa);
+    compiled.flags |= CompiledAutomaton::PATTERN_SET_FLAG;
+    return compiled;
+}
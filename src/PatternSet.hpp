@@ -0,0 +1,34 @@
+#ifndef __PATTERN_SET_HPP_
+#define __PATTERN_SET_HPP_
+
+#include <string>
+#include <vector>
+#include "Automaton.hpp"
+
+/** Several regular expressions compiled into a single deterministic automaton.
+ *
+ *  The automatons of the patterns are joined in one pass under a new beginning state with an
+ *  epsilon transition to the beginning states of every pattern, and determined together.
+ *  Every final state remembers which patterns it accepts, so one pass over a word tells all
+ *  patterns that recognize it.
+ *
+ */
+class PatternSet {
+private:
+    std::vector<Automaton> patterns;
+
+public:
+    ///Adds a pattern given as a regular expression. Returns the id of the pattern.
+    int add(const std::string&);
+
+    ///Adds a pattern given as an automaton. Returns the id of the pattern.
+    int add(const Automaton&);
+
+    ///Gets the number of patterns.
+    std::size_t size() const;
+
+    ///Compiles all patterns into one automaton. Its matchPatterns() reports the pattern ids.
+    CompiledAutomaton compile(bool minimized = false) const;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#include "RegexExpression.hpp"
+
+#include <algorithm>
+#include <utility>
+
+bool RegexExpression::NodeData::operator == (const NodeData& other) const {
+    return kind == other.kind && operands == other.operands && letters == other.letters;
+}
+
+std::size_t RegexExpression::NodeHash::operator()(const NodeData& data) const {
+    std::size_t hash = 14695981039346656037ull ^ (std::size_t) data.kind;
+    for (Node operand : data.operands) {
+        hash = (hash ^ (std::size_t) operand) * 1099511628211ull;
+    }
+    for (char letter : data.letters) {
+        hash = (hash ^ (unsigned char) letter) * 1099511628211ull;
+    }
+    return hash;
+}
+
+RegexExpression::RegexExpression() {
+    addNode({Kind::nothing, {}, ""});
+    addNode({Kind::emptyWord, {}, ""});
+}
+
+RegexExpression::Node RegexExpression::addNode(NodeData data) {
+    auto found = ids.find(data);
+    if (found != ids.end()) return found -> second;
+
+    Node node = nodes.size();
+    ids.emplace(data, node);
+    nodes.push_back(std::move(data));
+    return node;
+}
+
+RegexExpression::Node RegexExpression::letters(const std::set<char>& letterSet) {
+    if (letterSet.empty()) return NOTHING;
+    return addNode({Kind::letters, {}, std::string(letterSet.begin(), letterSet.end())});
+}
+
+RegexExpression::Node RegexExpression::un(Node first, Node second) {
+    if (first == NOTHING || first == second) return second;
+    if (second == NOTHING) return first;
+
+    //The operands of nested unions are pulled up and their letters merged into one node.
+    std::vector<Node> operands;
+    std::string letterSet;
+    bool emptyWord = false, iteration = false;
+    for (Node node : {first, second}) {
+        const NodeData& data = nodes[node];
+        const std::vector<Node> single = {node};
+        for (Node operand : data.kind == Kind::un ? data.operands : single) {
+            const NodeData& operandData = nodes[operand];
+            if (operandData.kind == Kind::letters) {
+                letterSet += operandData.letters;
+            }
+            else if (operandData.kind == Kind::emptyWord) {
+                emptyWord = true;
+            }
+            else {
+                iteration = iteration || operandData.kind == Kind::iteration;
+                operands.push_back(operand);
+            }
+        }
+    }
+
+    if (!letterSet.empty()) {
+        std::sort(letterSet.begin(), letterSet.end());
+        letterSet.erase(std::unique(letterSet.begin(), letterSet.end()), letterSet.end());
+        operands.push_back(addNode({Kind::letters, {}, letterSet}));
+    }
+
+    //An iteration already reads the empty word.
+    if (emptyWord && !iteration) operands.push_back(EMPTY_WORD);
+
+    std::sort(operands.begin(), operands.end());
+    operands.erase(std::unique(operands.begin(), operands.end()), operands.end());
+    if (operands.size() == 1) return operands.front();
+    return addNode({Kind::un, std::move(operands), ""});
+}
+
+RegexExpression::Node RegexExpression::concat(Node first, Node second) {
+    if (first == NOTHING || second == NOTHING) return NOTHING;
+    if (first == EMPTY_WORD) return second;
+    if (second == EMPTY_WORD) return first;
+    return addNode({Kind::concat, {first, second}, ""});
+}
+
+RegexExpression::Node RegexExpression::iteration(Node node) {
+    if (node == NOTHING || node == EMPTY_WORD) return EMPTY_WORD;
+    if (nodes[node].kind == Kind::iteration) return node;
+
+    //The iteration reads the empty word anyway, so it can be left out of the union.
+    if (nodes[node].kind == Kind::un && nodes[node].operands.front() == EMPTY_WORD) {
+        std::vector<Node> operands(nodes[node].operands.begin() + 1, nodes[node].operands.end());
+        node = operands.size() == 1 ? operands.front() : addNode({Kind::un, std::move(operands), ""});
+        if (nodes[node].kind == Kind::iteration) return node;
+    }
+
+    return addNode({Kind::iteration, {node}, ""});
+}
+
+std::size_t RegexExpression::size() const {
+    return nodes.size();
+}
+
+int RegexExpression::getPriority(Node node) const {
+    switch (nodes[node].kind) {
+        case Kind::letters:
+            return nodes[node].letters.size() == 1 ? 4 : 1;
+        case Kind::un:
+            return 1;
+        case Kind::concat:
+            return 2;
+        case Kind::iteration:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+std::string RegexExpression::toString(Node root) const {
+    std::vector<std::string> texts(nodes.size());
+    std::vector<bool> done(nodes.size(), false);
+
+    auto operandText = [&](Node operand, int priority) {
+        if (getPriority(operand) >= priority) return texts[operand];
+        return "(" + texts[operand] + ")";
+    };
+
+    //Post-order walk with an explicit stack, the expressions can be deeper than the call stack.
+    std::vector<std::pair<Node, bool>> stack = {{root, false}};
+    while (!stack.empty()) {
+        Node node = stack.back().first;
+        bool operandsDone = stack.back().second;
+        stack.pop_back();
+        if (done[node]) continue;
+
+        const NodeData& data = nodes[node];
+        if (!operandsDone && !data.operands.empty()) {
+            stack.push_back({node, true});
+            for (Node operand : data.operands) {
+                stack.push_back({operand, false});
+            }
+            continue;
+        }
+
+        std::string& text = texts[node];
+        switch (data.kind) {
+            case Kind::nothing:
+                break;
+            case Kind::emptyWord:
+                text = "@";
+                break;
+            case Kind::letters:
+                for (char letter : data.letters) {
+                    if (!text.empty()) text += '+';
+                    text += letter;
+                }
+                break;
+            case Kind::un:
+                for (Node operand : data.operands) {
+                    if (!text.empty()) text += '+';
+                    text += texts[operand];
+                }
+                break;
+            case Kind::concat:
+                text = operandText(data.operands[0], 2) + "." + operandText(data.operands[1], 2);
+                break;
+            case Kind::iteration:
+                text = operandText(data.operands[0], 4) + "*";
+                break;
+        }
+        done[node] = true;
+    }
+
+    return texts[root];
+}
@@ -0,0 +1,101 @@
+#ifndef __REGEX_EXPRESSION_HPP_
+#define __REGEX_EXPRESSION_HPP_
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Regular expression stored as a graph of shared sub-expressions.
+ *
+ *  Every expression is a node id. Combining expressions only adds a node that points to its
+ *  operands, so an expression used in many places is stored once and the work to build a
+ *  result does not depend on how long its text is. The text is created once by toString().
+ *
+ *  Nodes are hash-consed: building an expression equal to an existing one returns the
+ *  existing node. The operations also simplify their result:
+ *
+ *  - unions are flattened, their operands sorted and deduplicated (r+r = r) and their
+ *    letters merged into one set,
+ *  - nothing is dropped from unions and makes concatenations nothing,
+ *  - the empty word is dropped from concatenations (@.r = r),
+ *  - iterations of nothing and of the empty word are the empty word, (r*)* = r*,
+ *    (@+r)* = r*, and @+r* = r*.
+ *
+ */
+class RegexExpression {
+public:
+    ///Id of an expression.
+    using Node = int;
+
+    ///The expression that matches nothing. It has no text of its own, an empty string stands for it.
+    static constexpr Node NOTHING = 0;
+
+    ///The expression that matches only the empty word.
+    static constexpr Node EMPTY_WORD = 1;
+
+private:
+    enum class Kind {
+        nothing,
+        emptyWord,
+        letters,
+        un,
+        concat,
+        iteration
+    };
+
+    struct NodeData {
+        Kind kind;
+
+        ///The operands of a union (sorted), a concatenation or an iteration.
+        std::vector<Node> operands;
+
+        ///The sorted letters of a letters node.
+        std::string letters;
+
+        bool operator == (const NodeData&) const;
+    };
+
+    struct NodeHash {
+        std::size_t operator()(const NodeData&) const;
+    };
+
+    std::vector<NodeData> nodes;
+
+    ///Finds every node by its contents.
+    std::unordered_map<NodeData, Node, NodeHash> ids;
+
+    ///Gets the node with the given contents, adding it if it does not exist yet.
+    Node addNode(NodeData);
+
+    ///Gets the priority of the node's top operator when it is written (higher binds tighter).
+    int getPriority(Node) const;
+
+public:
+    RegexExpression();
+
+    ///Expression that reads any one of the letters, or NOTHING if there are none.
+    Node letters(const std::set<char>&);
+
+    ///Expression that reads either of the expressions.
+    Node un(Node, Node);
+
+    ///Expression that reads the first expression and then the second one.
+    Node concat(Node, Node);
+
+    ///Expression that reads the expression any number of times.
+    Node iteration(Node);
+
+    ///Gets the number of nodes.
+    std::size_t size() const;
+
+    /** Writes the expression in the syntax readRegex() accepts.
+     *
+     *  Every node reachable from the given one is written once and reused wherever it appears.
+     *  Parentheses are added only where the priority of the operators needs them.
+     *
+     */
+    std::string toString(Node) const;
+};
+
+#endif
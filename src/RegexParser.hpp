@@ -0,0 +1,86 @@
+#ifndef __REGEX_PARSER_HPP_
+#define __REGEX_PARSER_HPP_
+
+#include <stdexcept>
+#include <string_view>
+#include "Tokenizer.hpp"
+
+/** The shunting-yard algorithm shared by RegexUtils::parseRegex() and StaticRegex.
+ *
+ *  Every operator is applied to the fragments as soon as it leaves the stack, so no RPN
+ *  expression is created in between. The builder creates and combines the fragments with
+ *  letter() ('@' is the empty word), concat(), un(), intersection() and iteration(), like
+ *  ThompsonBuilder. The stacks need empty(), size(), back(), push_back() and pop_back(), so
+ *  the parser runs on std::vector at run time and on fixed-size arrays at compile time.
+ *
+ */
+namespace RegexParser {
+    ///Pops the operands of the operator and pushes its result.
+    template <typename Builder, typename Fragments>
+    constexpr void applyOperator(Builder& builder, Fragments& fragments, char oper) {
+        if (oper == '*' && !fragments.empty()) {
+            fragments.back() = builder.iteration(fragments.back());
+        }
+        else if (oper != '*' && fragments.size() >= 2) {
+            auto first = fragments.back();
+            fragments.pop_back();
+
+            auto& second = fragments.back();
+            switch (oper) {
+                case '.':
+                    second = builder.concat(second, first);
+                    break;
+                case '+':
+                    second = builder.un(second, first);
+                    break;
+                case '&':
+                    second = builder.intersection(second, first);
+                    break;
+            }
+        }
+    }
+
+    /** Parses the regular expression.
+     *
+     *  The fragment of the whole expression is left on top of the fragments, which stay empty
+     *  for an empty expression. Throws std::runtime_error on an unmatched closing bracket.
+     *
+     */
+    template <typename Builder, typename Fragments, typename Operators>
+    constexpr void parse(std::string_view regex, Builder& builder, Fragments& fragments, Operators& operators) {
+        Tokenizer tokenizer(regex);
+
+        while (tokenizer.hasMore()) {
+            Tokenizer::Token token = tokenizer.getToken();
+
+            if (token.type == Tokenizer::Token::letter) {
+                fragments.push_back(builder.letter(token.symbol));
+            }
+            else if (token.type == Tokenizer::Token::oper) {
+                while (!operators.empty() && operators.back().type == Tokenizer::Token::oper && operators.back().priority() >= token.priority()) {
+                    applyOperator(builder, fragments, operators.back().symbol);
+                    operators.pop_back();
+                }
+                operators.push_back(token);
+            }
+            else if (token.type == Tokenizer::Token::open_bracket) {
+                operators.push_back(token);
+            }
+            else if (token.type == Tokenizer::Token::closing_bracket) {
+                while (!operators.empty() && operators.back().type != Tokenizer::Token::open_bracket) {
+                    applyOperator(builder, fragments, operators.back().symbol);
+                    operators.pop_back();
+                }
+                if (operators.empty()) throw std::runtime_error("Unmatched closing bracket!");
+                operators.pop_back();
+            }
+        }
+
+        while (!operators.empty()) {
+            if (operators.back().type == Tokenizer::Token::oper) applyOperator(builder, fragments, operators.back().symbol);
+            operators.pop_back();
+        }
+    }
+}
+
+#endif
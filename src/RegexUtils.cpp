@@ -1,177 +1,216 @@
 #include "RegexUtils.hpp"
 
-#include <sstream>
-#include <stack>
-
-int getPriority(Tokenizer::Token token) {
-    switch (token.symbol) {
-        case '*': return 3;
-        case '.': return 2;
-        case '&': 
-        case '+': return 1;
-        default: return 0;
-    }
-}
-
-Automaton createBasicAutomaton (Automaton::TransitionLetters letters) {
-    Automaton newAutomaton;
-    newAutomaton.addState(1, true, false);
-    newAutomaton.addState(2, false, true);
-    newAutomaton.addTransition(std::make_pair(1,2), letters);
-
-    return newAutomaton;
-}
-
-Automaton applyKleeneStar (Automaton automaton) {
-    Automaton newAutomaton = automaton;
-    return Automaton::iteration(automaton);
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include "RegexParser.hpp"
+
+Automaton RegexUtils::parseRegex(std::string_view regex) {
+    ThompsonBuilder builder;
+    std::vector<ThompsonBuilder::Fragment> fragments;
+    std::vector<Tokenizer::Token> operators;
+    RegexParser::parse(regex, builder, fragments, operators);
+
+    if (fragments.empty()) return Automaton();
+    return builder.build(fragments.back());
 }
 
-Automaton applyRestOperations (char oper, Automaton first, Automaton second) {
-    switch (oper) {
-        case '.':
-            return Automaton::concat(second, first);
-        case '+':
-            return Automaton::un(second, first);
-        case '&': 
-            return Automaton::intersection(second, first);
+std::string RegexUtils::automatonToRegex(const Automaton& automaton) {
+    RegexExpression expression;
+
+    //The states are the ids of the compact automaton, the extra beginning and final states are n and n + 1.
+    std::shared_ptr<const CompactNfa> snapshot = automaton.getCompactNfa();
+    const CompactNfa& nfa = *snapshot;
+    std::size_t n = nfa.stateCount();
+    std::size_t beginning = n, final = n + 1;
+
+    //Every edge is labelled with the expression for the words read between its states.
+    std::vector<std::map<std::size_t, RegexExpression::Node>> outgoing(n + 2);
+    std::vector<std::set<std::size_t>> incoming(n + 2);
+    auto addPath = [&](std::size_t from, std::size_t to, RegexExpression::Node node) {
+        if (node == RegexExpression::NOTHING) return;
+        RegexExpression::Node& path = outgoing[from][to];
+        path = expression.un(path, node);
+        incoming[to].insert(from);
+    };
+
+    //States that reach each other by epsilon transitions recognize the same words, so each
+    //such group (a strongly connected component, found with Kosaraju's algorithm) is merged
+    //into one state. The epsilon cycles of Thompson's construction and intersection would
+    //otherwise multiply the paths through every eliminated state.
+    std::vector<std::vector<std::size_t>> epsilonEdges(n), reversedEpsilonEdges(n);
+    for (std::size_t state = 0; state < n; state++) {
+        for (std::size_t to : nfa.getEpsilonEdges(state)) {
+            epsilonEdges[state].push_back(to);
+            reversedEpsilonEdges[to].push_back(state);
+        }
     }
-    return first;
-}
-
-Automaton RegexUtils::evaluateRegex (Tokenizer tokenizer) {
-    std::stack<Automaton> automatonStack;
 
-    Tokenizer::Token token = tokenizer.getToken();
-    
-    while (tokenizer.hasMore())
-    {
-        if (token.type == Tokenizer::Token::letter){
-            char c = token.symbol;
-            if (token.symbol == '@') c = EPSILON;
+    std::vector<std::size_t> finished;
+    std::vector<bool> visited(n, false);
+    std::vector<std::pair<std::size_t, std::size_t>> path;
+    for (std::size_t state = 0; state < n; state++) {
+        if (visited[state]) continue;
+        visited[state] = true;
+        path.push_back(std::make_pair(state, 0));
+
+        while (!path.empty()) {
+            std::size_t current = path.back().first, edge = path.back().second;
+            if (edge == epsilonEdges[current].size()) {
+                finished.push_back(current);
+                path.pop_back();
+                continue;
+            }
 
-            automatonStack.push (createBasicAutomaton({c}));
-        }
-        else {
-            if (token.type == Tokenizer::Token::oper) {
-                if (automatonStack.size() >= 2) {
-                    if (token.symbol == '*') {
-                        Automaton automaton = automatonStack.top();
-                        automatonStack.pop();
-
-                        automatonStack.push(applyKleeneStar(automaton));
-                    }   
-                    else {
-                        Automaton first = automatonStack.top(); 
-                        automatonStack.pop();
-
-                        Automaton second = automatonStack.top();
-                        automatonStack.pop();
-
-                        automatonStack.push ( applyRestOperations(token.symbol, first, second));
-                    }
-                }
-                else if (automatonStack.size() == 1 && token.symbol == '*') {
-                    Automaton automaton = automatonStack.top();
-                    automatonStack.pop();
-
-                    automatonStack.push(applyKleeneStar(automaton));
-                }
+            path.back().second++;
+            std::size_t to = epsilonEdges[current][edge];
+            if (!visited[to]) {
+                visited[to] = true;
+                path.push_back(std::make_pair(to, 0));
             }
         }
-        token = tokenizer.getToken();
-
     }
-    return automatonStack.top();
-}
-
-std::string RegexUtils::shuntingYardAlgo (Tokenizer tokenizer) {
-    std::stringstream sstr;
 
-    std::stack<Tokenizer::Token> operatorStack;
+    std::vector<std::size_t> group(n, SIZE_MAX), stack;
+    for (auto root = finished.rbegin(); root != finished.rend(); root++) {
+        if (group[*root] != SIZE_MAX) continue;
+        group[*root] = *root;
+        stack.push_back(*root);
+
+        while (!stack.empty()) {
+            std::size_t current = stack.back();
+            stack.pop_back();
+            for (std::size_t from : reversedEpsilonEdges[current]) {
+                if (group[from] != SIZE_MAX) continue;
+                group[from] = *root;
+                stack.push_back(from);
+            }
+        }
+    }
 
-    Tokenizer::Token token = tokenizer.getToken();
+    //Every group is named by its first state, which keeps the order of the elimination stable.
+    std::vector<std::size_t> firstState(n, SIZE_MAX);
+    for (std::size_t state = 0; state < n; state++) {
+        if (firstState[group[state]] == SIZE_MAX) firstState[group[state]] = state;
+        group[state] = firstState[group[state]];
+    }
 
-    while (tokenizer.hasMore()) { 
-        if (token.type == Tokenizer::Token::letter) {
-            sstr << token.symbol;
+    //Only the states on a path from a beginning state to a final state are kept. The dead ends
+    //left by intersection would otherwise do the same.
+    std::vector<std::vector<std::size_t>> successors(n), predecessors(n);
+    for (std::size_t state = 0; state < n; state++) {
+        for (std::size_t to : epsilonEdges[state]) {
+            successors[group[state]].push_back(group[to]);
+            predecessors[group[to]].push_back(group[state]);
         }
-        else if (token.type == Tokenizer::Token::oper) {
-            while (!operatorStack.empty() && operatorStack.top().type == Tokenizer::Token::oper && getPriority(operatorStack.top()) >= getPriority(token)) {
-                sstr << operatorStack.top().symbol;
-                operatorStack.pop();
-            }
-            operatorStack.push(token);
+        for (std::size_t edge = nfa.letterEdgesBegin(state); edge < nfa.letterEdgesEnd(state); edge++) {
+            std::size_t to = nfa.getEdgeTarget(edge);
+            successors[group[state]].push_back(group[to]);
+            predecessors[group[to]].push_back(group[state]);
         }
-        else if (token.type == Tokenizer::Token::open_bracket) {
-            operatorStack.push(token);
+    }
+
+    std::vector<bool> reachable(n, false), useful(n, false);
+    for (std::size_t beginningState : nfa.getBeginningStates()) {
+        if (!reachable[group[beginningState]]) {
+            reachable[group[beginningState]] = true;
+            stack.push_back(group[beginningState]);
         }
-        else if (token.type == Tokenizer::Token::closing_bracket) {
-            while (!operatorStack.empty() && operatorStack.top().type != Tokenizer::Token::open_bracket) {
-                sstr << operatorStack.top().symbol;
-                operatorStack.pop();
-            }
-            operatorStack.pop();
+    }
+    while (!stack.empty()) {
+        std::size_t current = stack.back();
+        stack.pop_back();
+        for (std::size_t to : successors[current]) {
+            if (reachable[to]) continue;
+            reachable[to] = true;
+            stack.push_back(to);
         }
-        token = tokenizer.getToken();
     }
 
-    while (!operatorStack.empty()) {
-        sstr << operatorStack.top().symbol;
-        operatorStack.pop();
+    for (std::size_t state = 0; state < n; state++) {
+        if (nfa.isFinal(state) && reachable[group[state]] && !useful[group[state]]) {
+            useful[group[state]] = true;
+            stack.push_back(group[state]);
+        }
+    }
+    while (!stack.empty()) {
+        std::size_t current = stack.back();
+        stack.pop_back();
+        for (std::size_t from : predecessors[current]) {
+            if (useful[from] || !reachable[from]) continue;
+            useful[from] = true;
+            stack.push_back(from);
+        }
     }
 
-    return sstr.str();
-}
+    for (std::size_t state = 0; state < n; state++) {
+        std::size_t from = group[state];
+        if (!useful[from]) continue;
 
-std::string RegexUtils::automatonToRegex(Automaton automaton, int state1, int state2, int k) {
-    std::stringstream result;
-    if (k == 1) {
-        if (automaton.getNeighbours().at(state1).count(state2) == 0) {
-            return "";
+        for (std::size_t to : epsilonEdges[state]) {
+            if (useful[group[to]] && group[to] != from) addPath(from, group[to], RegexExpression::EMPTY_WORD);
         }
-        Automaton::TransitionLetters transitionLetters = automaton.getTransitions().at(std::make_pair(state1, state2));
-        if (state1 == state2) {
-            result << '@';
-            for (char c : transitionLetters) {
-                result << '+' << c;
-            }
-        }
-        else {
-            result << *transitionLetters.begin();
-            transitionLetters.erase(transitionLetters.begin());
-            for (char c : transitionLetters) {
-                result << '+' << c;
-            }
+        for (std::size_t edge = nfa.letterEdgesBegin(state); edge < nfa.letterEdgesEnd(state); edge++) {
+            std::size_t to = group[nfa.getEdgeTarget(edge)];
+            if (!useful[to]) continue;
+
+            CompactNfa::Letters letters(nfa.getEdgeMask(edge), false);
+            addPath(from, to, expression.letters(std::set<char>(letters.begin(), letters.end())));
         }
     }
-    else {
-        bool includePlus = true;
-        std::string firstExp = automatonToRegex(automaton, state1, state2, k-1);
-        std::string secondExp = automatonToRegex(automaton, state1, k-1, k-1);
-        std::string thirdExp = automatonToRegex(automaton, k-1, k-1, k-1);
-        std::string fourthExp = automatonToRegex(automaton, k-1, state2, k-1);
-
-        std::string kleeneStarExp = "(" + thirdExp + ")*.";
-        if (thirdExp == "") kleeneStarExp = "";    
-
-        std::string secondpart = "("+secondExp + ")." + kleeneStarExp + "(" + fourthExp + ")";
-        if (firstExp == "") {
-            includePlus = false;
+    for (std::size_t beginningState : nfa.getBeginningStates()) {
+        if (useful[group[beginningState]]) addPath(beginning, group[beginningState], RegexExpression::EMPTY_WORD);
+    }
+    for (std::size_t state = 0; state < n; state++) {
+        if (nfa.isFinal(state) && useful[group[state]]) addPath(group[state], final, RegexExpression::EMPTY_WORD);
+    }
+
+    //State elimination, the state with the fewest paths through it goes first.
+    std::vector<bool> eliminated(n, false);
+    for (std::size_t step = 0; step < n; step++) {
+        std::size_t state = n;
+        std::size_t bestCost = SIZE_MAX;
+        for (std::size_t candidate = 0; candidate < n; candidate++) {
+            if (eliminated[candidate]) continue;
+
+            bool loop = outgoing[candidate].count(candidate) != 0;
+            std::size_t cost = (incoming[candidate].size() - loop) * (outgoing[candidate].size() - loop);
+            if (cost < bestCost) {
+                bestCost = cost;
+                state = candidate;
+            }
         }
-        else {
-            firstExp = "(" + firstExp + ")";
+        eliminated[state] = true;
+
+        auto loop = outgoing[state].find(state);
+        RegexExpression::Node iteration = RegexExpression::NOTHING;
+        if (loop != outgoing[state].end()) iteration = expression.iteration(loop -> second);
+
+        for (std::size_t from : incoming[state]) {
+            if (from == state) continue;
+
+            RegexExpression::Node prefix = outgoing[from][state];
+            if (iteration != RegexExpression::NOTHING) prefix = expression.concat(prefix, iteration);
+
+            for (auto& path : outgoing[state]) {
+                if (path.first == state) continue;
+                addPath(from, path.first, expression.concat(prefix, path.second));
+            }
         }
-        if (secondExp == "" || fourthExp == "") {
-            includePlus = false;
-            secondpart = "";
+
+        for (std::size_t from : incoming[state]) {
+            outgoing[from].erase(state);
         }
-        result << firstExp;
-        if (includePlus) {
-            result << '+';
+        for (auto& path : outgoing[state]) {
+            incoming[path.first].erase(state);
         }
-        result << secondpart;
-    }   
-    return result.str();
-}
+        outgoing[state].clear();
+        incoming[state].clear();
+    }
 
+    auto result = outgoing[beginning].find(final);
+    if (result == outgoing[beginning].end()) return "";
+    return expression.toString(result -> second);
+}
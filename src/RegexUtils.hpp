@@ -2,18 +2,33 @@
 #define __REGEX_HPP_
 
 #include <iostream>
+#include <string_view>
 #include "Tokenizer.hpp"
 #include "Automaton.hpp"
+#include "ThompsonBuilder.hpp"
+#include "RegexExpression.hpp"
 
 namespace RegexUtils {
-    ///Converts a regular expression to reversed polish notation regular expression.
-    std::string shuntingYardAlgo(Tokenizer);
+    /** Converts a regular expression to automaton in one pass.
+     * 
+     *  Runs the shunting-yard algorithm and applies every operator to Thompson fragments as
+     *  soon as it is popped, so no RPN expression is created in between.
+     * 
+     */
+    Automaton parseRegex(std::string_view);
 
-    ///Evaluates a RPN regular expression.
-    Automaton evaluateRegex (Tokenizer);
-
-    ///Converts the given automaton to regular expression.
-    std::string automatonToRegex(Automaton, int, int, int);
+    /** Converts the given automaton to regular expression.
+     * 
+     *  The automaton is not determined. The states that reach each other by epsilon
+     *  transitions are merged first and the states on no path from a beginning state to a
+     *  final state are dropped. Then uses state elimination: the states are removed one by
+     *  one, the state with the fewest paths through it first, and every path through a removed
+     *  state is replaced by a direct edge. Every edge expression is built once and kept in a
+     *  RegexExpression, so shared parts are not copied until the text is written. O(n^3) for n
+     *  states.
+     * 
+     */
+    std::string automatonToRegex(const Automaton&);
 }
 
 
@@ -0,0 +1,147 @@
+#include "SearchAutomaton.hpp"
+#include <algorithm>
+#include <set>
+
+namespace {
+    ///Distance between the positions where the extensions of matches record their states.
+    constexpr std::size_t CHECKPOINT_DISTANCE = 64;
+
+    Automaton fromRegex(std::string_view regex) {
+        Automaton automaton;
+        automaton.readRegex(regex);
+        return automaton;
+    }
+
+    /** Removes the empty word from the recognized words.
+     *
+     *  Otherwise ?*.reverse(r) would be final before every position, since the prefix can
+     *  read the whole rest of the text.
+     *
+     */
+    Automaton withoutEmptyWord(const Automaton& automaton) {
+        if (!automaton.recognize("")) return automaton;
+        return Automaton::intersection(automaton, fromRegex("?.?*"));
+    }
+}
+
+SearchAutomaton::SearchAutomaton(const Automaton& automaton, bool minimized) {
+    Automaton pattern = withoutEmptyWord(automaton);
+    Automaton anyPrefix = fromRegex("?*");
+
+    anchored = pattern.compile(minimized);
+    unanchored = Automaton::concat(anyPrefix, pattern).compile(minimized);
+    reversed = Automaton::concat(anyPrefix, Automaton::reverse(pattern)).compile(minimized);
+}
+
+bool SearchAutomaton::contains(std::string_view text) const {
+    std::uint32_t current = unanchored.getBeginningState();
+    for (char c : text) {
+        current = unanchored.next(current, c);
+        if (unanchored.isFinal(current)) return true;
+    }
+
+    return false;
+}
+
+std::size_t SearchAutomaton::findLastEnd(std::string_view text) const {
+    std::uint32_t current = unanchored.getBeginningState();
+    if (current == CompiledAutomaton::DEAD_STATE) return 0;
+
+    std::size_t lastEnd = 0;
+    for (std::size_t i = 0; i < text.size(); i++) {
+        current = unanchored.next(current, text[i]);
+        if (unanchored.isFinal(current)) lastEnd = i + 1;
+    }
+
+    return lastEnd;
+}
+
+void SearchAutomaton::findWindowStates(std::string_view text, std::size_t end, std::vector<std::uint32_t>& windowStates, std::vector<std::uint64_t>& starts) const {
+    windowStates.assign((end + START_WINDOW - 1) / START_WINDOW, reversed.getBeginningState());
+    starts.assign(START_WINDOW / 64, 0);
+
+    //Reading text[i] backward leaves a final state if text[i..j - 1] is a match for some j <= end,
+    //the prefix of the reversed automaton reads the rest.
+    std::uint32_t current = reversed.getBeginningState();
+    for (std::size_t i = end; i-- > 0;) {
+        if ((i + 1) % START_WINDOW == 0) windowStates[i / START_WINDOW] = current;
+
+        current = reversed.next(current, text[i]);
+        if (i < START_WINDOW && reversed.isFinal(current)) starts[i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+}
+
+void SearchAutomaton::findStarts(std::string_view text, std::size_t window, std::size_t end, std::uint32_t current, std::vector<std::uint64_t>& starts) const {
+    std::fill(starts.begin(), starts.end(), 0);
+
+    std::size_t first = window * START_WINDOW;
+    for (std::size_t i = std::min(end, first + START_WINDOW); i-- > first;) {
+        current = reversed.next(current, text[i]);
+        if (reversed.isFinal(current)) starts[(i - first) / 64] |= std::uint64_t(1) << ((i - first) % 64);
+    }
+}
+
+std::vector<SearchAutomaton::Match> SearchAutomaton::findAll(std::string_view text) const {
+    std::vector<Match> matches;
+
+    //No match ends after lastEnd, so nothing behind it has to be read again.
+    std::size_t lastEnd = findLastEnd(text);
+    if (lastEnd == 0) return matches;
+
+    //The starts of the first window are marked by the same pass, the other ones when the search gets there.
+    std::vector<std::uint32_t> windowStates;
+    std::vector<std::uint64_t> starts;
+    findWindowStates(text, lastEnd, windowStates, starts);
+    std::size_t window = 0;
+
+    /** The states extensions had at the checkpoints, keyed by checkpoint << 32 | state.
+     *
+     *  An extension never finds a match end after the start of the next one, so none can be
+     *  found from a state an earlier extension already had at the same position. A later
+     *  extension that reaches it stops there, which bounds the work by the number of checkpoint
+     *  and state pairs instead of the number of matches times the length of the text. The
+     *  extensions start after the end of the last match, so the keys behind it are dropped.
+     *
+     */
+    std::set<std::uint64_t> visited;
+
+    std::size_t position = 0;
+    while (position < lastEnd) {
+        if (position / START_WINDOW != window) {
+            window = position / START_WINDOW;
+            findStarts(text, window, lastEnd, windowStates[window], starts);
+        }
+
+        //The leftmost start at or after the position in its window.
+        std::size_t offset = position - window * START_WINDOW;
+        std::size_t word = offset / 64;
+        std::uint64_t bits = starts[word] & (~std::uint64_t(0) << (offset % 64));
+        while (bits == 0 && ++word < starts.size()) {
+            bits = starts[word];
+        }
+        if (bits == 0) {
+            position = (window + 1) * START_WINDOW;
+            continue;
+        }
+        std::size_t start = window * START_WINDOW + word * 64 + __builtin_ctzll(bits);
+
+        //The longest match from the start, it is not empty because the start was marked.
+        std::size_t end = start;
+        std::uint32_t current = anchored.getBeginningState();
+        for (std::size_t i = start; i < lastEnd && current != CompiledAutomaton::DEAD_STATE; i++) {
+            current = anchored.next(current, text[i]);
+            if (anchored.isFinal(current)) end = i + 1;
+
+            if ((i + 1) % CHECKPOINT_DISTANCE == 0) {
+                std::uint64_t key = (std::uint64_t) ((i + 1) / CHECKPOINT_DISTANCE) << 32 | current;
+                if (!visited.insert(key).second) break;
+            }
+        }
+
+        matches.push_back({start, end});
+        position = end;
+        visited.erase(visited.begin(), visited.lower_bound((std::uint64_t) (position / CHECKPOINT_DISTANCE + 1) << 32));
+    }
+
+    return matches;
+}
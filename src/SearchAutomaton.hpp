@@ -0,0 +1,79 @@
+#ifndef __SEARCH_AUTOMATON_HPP_
+#define __SEARCH_AUTOMATON_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "Automaton.hpp"
+
+/** Finds the parts of a text recognized by an automaton, with their positions.
+ *
+ *  Three deterministic automatons are compiled from the pattern r:
+ *
+ *  - ?*.r reads the text forward in one pass and is final after every position where a
+ *    match ends, so the text is rejected without any other work if nothing matches,
+ *  - ?*.reverse(r) reads the text backward from the end of the last match and is final
+ *    before every position where a match starts,
+ *  - r itself extends a match from its start to its longest end.
+ *
+ *  An extension stops early when it reaches a state an earlier one had at the same position,
+ *  checked every 64 bytes, so findAll() takes time linear in the length of the text for a
+ *  given pattern even when the extensions would all read to the end of the text.
+ *
+ *  The starts are marked one window of START_WINDOW positions at a time, from the state the
+ *  reversed automaton had at the end of the window, and the states of the extensions are
+ *  dropped once the search is past them. So besides the matches findAll() keeps a few bytes
+ *  per window and not per position of the text.
+ *
+ *  The matches are the leftmost-longest ones and do not overlap, like those of grep -o. Only
+ *  matches of at least one byte are reported.
+ *
+ */
+class SearchAutomaton {
+public:
+    ///Number of positions findAll() marks the starts of at a time.
+    static constexpr std::size_t START_WINDOW = std::size_t(1) << 16;
+
+    ///Part of the text from start to end - 1 (offsets in bytes).
+    struct Match {
+        std::size_t start;
+        std::size_t end;
+    };
+
+private:
+    ///Recognizes the pattern.
+    CompiledAutomaton anchored;
+
+    ///Recognizes the pattern after any prefix.
+    CompiledAutomaton unanchored;
+
+    ///Recognizes the reversed pattern after any prefix.
+    CompiledAutomaton reversed;
+
+    ///Gets the position after the end of the last match (0 if there is none).
+    std::size_t findLastEnd(std::string_view) const;
+
+    /** Reads the text backward from the given end with the reversed automaton.
+     * 
+     *  Keeps the state before every window of START_WINDOW positions, the state at the end of
+     *  window k is windowStates[k], and marks the starts in the first window on the way.
+     * 
+     */
+    void findWindowStates(std::string_view, std::size_t, std::vector<std::uint32_t>& windowStates, std::vector<std::uint64_t>& starts) const;
+
+    ///Marks every position in the window before the given end where a match starts, from the state at its end.
+    void findStarts(std::string_view, std::size_t window, std::size_t, std::uint32_t, std::vector<std::uint64_t>&) const;
+
+public:
+    ///Compiles the automatons. If minimized is set, they are minimized too.
+    explicit SearchAutomaton(const Automaton&, bool minimized = false);
+
+    ///Checks if some part of the text is recognized. Stops at the end of the first match.
+    bool contains(std::string_view) const;
+
+    ///Finds all matches in the text, ordered by their positions.
+    std::vector<Match> findAll(std::string_view) const;
+};
+
+#endif
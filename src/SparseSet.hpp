@@ -0,0 +1,62 @@
+#ifndef __SPARSE_SET_HPP_
+#define __SPARSE_SET_HPP_
+
+#include <cstddef>
+#include <vector>
+
+/** Set of integers in the range [0, capacity).
+ *
+ *  Insertion, lookup and clearing are O(1) and the elements are iterated in insertion order,
+ *  which is what a state-by-state NFA simulation needs.
+ *
+ */
+class SparseSet {
+private:
+    ///The elements in insertion order.
+    std::vector<int> dense;
+
+    ///Position of every element inside dense.
+    std::vector<std::size_t> sparse;
+
+    ///Number of elements in the set.
+    std::size_t count = 0;
+
+public:
+    explicit SparseSet(std::size_t capacity = 0) : dense(capacity), sparse(capacity) {}
+
+    ///Checks if the value is in the set.
+    bool contains(int value) const {
+        std::size_t position = sparse[value];
+        return position < count && dense[position] == value;
+    }
+
+    ///Inserts the value. Returns false if it was already in the set.
+    bool insert(int value) {
+        if (contains(value)) return false;
+        dense[count] = value;
+        sparse[value] = count++;
+        return true;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    std::vector<int>::const_iterator begin() const {
+        return dense.begin();
+    }
+
+    std::vector<int>::const_iterator end() const {
+        return dense.begin() + count;
+    }
+};
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef __STATIC_REGEX_HPP_
+#define __STATIC_REGEX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include "RegexParser.hpp"
+#include "Tokenizer.hpp"
+
+/** Deterministic automaton built at compile time by StaticRegex::compile().
+ *
+ *  The table has the same layout as the one of CompiledAutomaton: state 0 is the dead state,
+ *  state 1 the beginning state and the transitions are indexed by state * MaxClasses + byteClass.
+ *  Declared static constexpr it lives in read-only data and needs no work at startup.
+ *
+ */
+template <std::size_t MaxStates, std::size_t MaxClasses>
+class StaticAutomaton {
+    static_assert(MaxStates < UINT16_MAX, "StaticAutomaton stores states in 16 bits");
+
+public:
+    ///The dead state. Every missing transition leads to it and it never leaves itself.
+    static constexpr std::uint16_t DEAD_STATE = 0;
+
+    ///Maps every byte to its equivalence class.
+    std::uint8_t byteClasses[256] = {};
+
+    ///The transition table, one row of MaxClasses entries per state.
+    std::uint16_t table[(MaxStates + 1) * MaxClasses] = {};
+
+    ///Whether every state is final.
+    bool finalStates[MaxStates + 1] = {};
+
+    ///The beginning state.
+    std::uint16_t beginningState = DEAD_STATE;
+
+    ///Number of states (including the dead state).
+    std::size_t states = 1;
+
+    ///Checks if the automaton recognizes the given word
+    constexpr bool match(std::string_view word) const {
+        std::uint16_t current = beginningState;
+
+        for (char c : word) {
+            if (current == DEAD_STATE) return false;
+            current = table[current * MaxClasses + byteClasses[(unsigned char) c]];
+        }
+
+        return finalStates[current];
+    }
+
+    ///Gets the number of states in the table (including the dead state).
+    constexpr std::size_t stateCount() const {
+        return states;
+    }
+};
+
+/** Compile-time version of the readRegex() and compile() pipeline.
+ *
+ *  The same tokenizer, shunting-yard and Thompson construction run on fixed-size arrays, and
+ *  the subset construction keeps the state sets as bitsets, so everything can be evaluated
+ *  by the compiler:
+ *
+ *      static constexpr auto pattern = StaticRegex::compile("(a+b)*.c");
+ *      pattern.match(word);
+ *
+ *  Intersection ('&') is not supported here. A pattern that uses it or needs more than
+ *  MaxStates deterministic states does not compile.
+ *
+ */
+namespace StaticRegex {
+    ///Marks the empty word in the letters of the automaton, like EPSILON does in Automaton.
+    constexpr char STATIC_EPSILON = (char) 238;
+
+    ///Part of the automaton with one beginning and one final state.
+    struct Fragment {
+        int beginning;
+        int final;
+    };
+
+    /** Thompson automaton of a regular expression with at most N characters.
+     *
+     *  Every token adds at most two states and every state has at most two transitions.
+     *
+     */
+    template <std::size_t N>
+    struct Nfa {
+        static constexpr std::size_t CAPACITY = 2 * N + 2;
+
+        char letters[CAPACITY][2] = {};
+        int targets[CAPACITY][2] = {};
+        int transitionCount[CAPACITY] = {};
+        int stateCount = 0;
+
+        constexpr int addState() {
+            return stateCount++;
+        }
+
+        constexpr void addTransition(int from, int to, char letter) {
+            letters[from][transitionCount[from]] = letter;
+            targets[from][transitionCount[from]++] = to;
+        }
+
+        constexpr Fragment letter(char c) {
+            Fragment fragment = {addState(), addState()};
+            addTransition(fragment.beginning, fragment.final, c == '@' ? STATIC_EPSILON : c);
+            return fragment;
+        }
+
+        constexpr Fragment concat(Fragment first, Fragment second) {
+            addTransition(first.final, second.beginning, STATIC_EPSILON);
+            return {first.beginning, second.final};
+        }
+
+        constexpr Fragment un(Fragment first, Fragment second) {
+            Fragment fragment = {addState(), addState()};
+            addTransition(fragment.beginning, first.beginning, STATIC_EPSILON);
+            addTransition(fragment.beginning, second.beginning, STATIC_EPSILON);
+            addTransition(first.final, fragment.final, STATIC_EPSILON);
+            addTransition(second.final, fragment.final, STATIC_EPSILON);
+            return fragment;
+        }
+
+        constexpr Fragment iteration(Fragment inner) {
+            Fragment fragment = {addState(), addState()};
+            addTransition(fragment.beginning, inner.beginning, STATIC_EPSILON);
+            addTransition(fragment.beginning, fragment.final, STATIC_EPSILON);
+            addTransition(inner.final, inner.beginning, STATIC_EPSILON);
+            addTransition(inner.final, fragment.final, STATIC_EPSILON);
+            return fragment;
+        }
+
+        ///Needs the product of two automatons, so a pattern with '&' does not compile.
+        constexpr Fragment intersection(Fragment first, Fragment second) {
+            if (first.beginning != second.beginning) throw std::runtime_error("Intersection is not supported at compile time!");
+            return first;
+        }
+    };
+
+    ///Stack on a fixed-size array with the members of std::vector the parser uses.
+    template <typename T, std::size_t N>
+    struct FixedStack {
+        T items[N] = {};
+        std::size_t count = 0;
+
+        constexpr bool empty() const { return count == 0; }
+        constexpr std::size_t size() const { return count; }
+        constexpr T& back() { return items[count - 1]; }
+        constexpr const T& back() const { return items[count - 1]; }
+        constexpr void push_back(const T& item) { items[count++] = item; }
+        constexpr void pop_back() { count--; }
+    };
+
+    ///Parsed regular expression: the automaton and its only beginning and final state.
+    template <std::size_t N>
+    struct ParsedRegex {
+        Nfa<N> nfa;
+        Fragment fragment = {-1, -1};
+    };
+
+    ///Same as RegexUtils::parseRegex(), on fixed-size arrays.
+    template <std::size_t N>
+    constexpr ParsedRegex<N> parse(std::string_view regex) {
+        ParsedRegex<N> result;
+        FixedStack<Fragment, N> fragments;
+        FixedStack<Tokenizer::Token, N> operators;
+        RegexParser::parse(regex, result.nfa, fragments, operators);
+
+        if (!fragments.empty()) result.fragment = fragments.back();
+        return result;
+    }
+
+    ///Set of Thompson states stored as bits.
+    template <std::size_t N>
+    struct StateSet {
+        static constexpr std::size_t WORDS = (Nfa<N>::CAPACITY + 63) / 64;
+
+        std::uint64_t words[WORDS] = {};
+
+        constexpr bool contains(int state) const {
+            return (words[state / 64] >> (state % 64)) & 1;
+        }
+
+        constexpr void insert(int state) {
+            words[state / 64] |= std::uint64_t(1) << (state % 64);
+        }
+
+        constexpr bool empty() const {
+            for (std::size_t i = 0; i < WORDS; i++) {
+                if (words[i] != 0) return false;
+            }
+            return true;
+        }
+
+        constexpr bool operator == (const StateSet& other) const {
+            for (std::size_t i = 0; i < WORDS; i++) {
+                if (words[i] != other.words[i]) return false;
+            }
+            return true;
+        }
+    };
+
+    ///Adds the state and everything reachable from it with epsilon transitions to the set.
+    template <std::size_t N>
+    constexpr void addClosure(const Nfa<N>& nfa, StateSet<N>& set, int state) {
+        if (set.contains(state)) return;
+
+        int stack[Nfa<N>::CAPACITY] = {};
+        std::size_t stackSize = 0;
+        set.insert(state);
+        stack[stackSize++] = state;
+
+        while (stackSize > 0) {
+            int top = stack[--stackSize];
+            for (int i = 0; i < nfa.transitionCount[top]; i++) {
+                int target = nfa.targets[top][i];
+                if (nfa.letters[top][i] == STATIC_EPSILON && !set.contains(target)) {
+                    set.insert(target);
+                    stack[stackSize++] = target;
+                }
+            }
+        }
+    }
+
+    /** Compiles the regular expression into a deterministic automaton.
+     *
+     *  Meant to be evaluated at compile time. MaxStates limits the number of deterministic
+     *  states (without the dead state), the number of byte classes is limited by the length of
+     *  the expression.
+     *
+     */
+    template <std::size_t MaxStates = 64, std::size_t N>
+    constexpr StaticAutomaton<MaxStates, N> compile(const char (&regex)[N]) {
+        StaticAutomaton<MaxStates, N> result;
+        ParsedRegex<N> parsed = parse<N>(std::string_view(regex, N - 1));
+        const Nfa<N>& nfa = parsed.nfa;
+        if (parsed.fragment.beginning < 0) return result;
+
+        //Class 0 holds every byte no transition mentions, only '?' reads it.
+        bool explicitLetters[256] = {};
+        for (int state = 0; state < nfa.stateCount; state++) {
+            for (int i = 0; i < nfa.transitionCount[state]; i++) {
+                char letter = nfa.letters[state][i];
+                if (letter != '?' && letter != STATIC_EPSILON) explicitLetters[(unsigned char) letter] = true;
+            }
+        }
+
+        std::size_t classCount = 1;
+        int representatives[N] = {};
+        representatives[0] = -1;
+        for (int byte = 0; byte < 256; byte++) {
+            if (explicitLetters[byte]) {
+                result.byteClasses[byte] = classCount;
+                representatives[classCount++] = byte;
+            }
+            else if (representatives[0] < 0) {
+                representatives[0] = byte;
+            }
+        }
+
+        //Deterministic state i is row i + 1 of the table.
+        StateSet<N> sets[MaxStates] = {};
+        std::size_t setCount = 1;
+        addClosure(nfa, sets[0], parsed.fragment.beginning);
+        result.beginningState = 1;
+
+        for (std::size_t current = 0; current < setCount; current++) {
+            result.finalStates[current + 1] = sets[current].contains(parsed.fragment.final);
+
+            for (std::size_t byteClass = 0; byteClass < classCount; byteClass++) {
+                if (representatives[byteClass] < 0) continue;
+                char letter = (char) representatives[byteClass];
+
+                StateSet<N> reached;
+                for (int state = 0; state < nfa.stateCount; state++) {
+                    if (!sets[current].contains(state)) continue;
+
+                    for (int i = 0; i < nfa.transitionCount[state]; i++) {
+                        char edgeLetter = nfa.letters[state][i];
+                        if (edgeLetter == letter || edgeLetter == '?') addClosure(nfa, reached, nfa.targets[state][i]);
+                    }
+                }
+                if (reached.empty()) continue;
+
+                std::size_t target = 0;
+                while (target < setCount && !(sets[target] == reached)) {
+                    target++;
+                }
+                if (target == setCount) {
+                    if (setCount == MaxStates) throw std::runtime_error("Too many states, raise MaxStates!");
+                    sets[setCount++] = reached;
+                }
+
+                result.table[(current + 1) * N + byteClass] = target + 1;
+            }
+        }
+
+        result.states = setCount + 1;
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "StreamMatcher.hpp"
+
+StreamMatcher::StreamMatcher(const CompiledAutomaton& automaton, FileScanner::RecordMode mode)
+    : automaton(automaton), mode(mode) {
+    reset();
+}
+
+void StreamMatcher::walk(const char* first, const char* last) {
+    if (first == last) return;
+
+    //The rest of a record whose result can not change any more is only skipped.
+    if (automaton.isSink(current)) {
+        beforeLast = current;
+        lastLetter = last[-1];
+        return;
+    }
+
+    std::uint32_t state = current;
+    for (const char* letter = first; letter < last - 1 && !automaton.isSink(state); letter++) {
+        state = automaton.next(state, *letter);
+    }
+
+    beforeLast = state;
+    current = automaton.next(state, last[-1]);
+    lastLetter = last[-1];
+}
+
+void StreamMatcher::startRecord(std::uint64_t start) {
+    current = automaton.getBeginningState();
+    beforeLast = CompiledAutomaton::DEAD_STATE;
+    lastLetter = '\0';
+    recordStart = start;
+}
+
+void StreamMatcher::feed(const char* data, std::size_t size) {
+    walk(data, data + size);
+    offset += size;
+}
+
+bool StreamMatcher::finish() {
+    bool accepted = automaton.isFinal(current);
+    startRecord(offset);
+    return accepted;
+}
+
+bool StreamMatcher::isDead() const {
+    return current == CompiledAutomaton::DEAD_STATE;
+}
+
+void StreamMatcher::reset() {
+    offset = 0;
+    inWord = false;
+    startRecord(0);
+}
@@ -0,0 +1,156 @@
+#ifndef __STREAM_MATCHER_HPP_
+#define __STREAM_MATCHER_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include "CompiledAutomaton.hpp"
+#include "FileScanner.hpp"
+
+/** Matches records that arrive in chunks of any size.
+ *
+ *  Only the state of the automaton after the bytes read so far is kept between the calls, so
+ *  a record split between two chunks is matched without being copied into one string and the
+ *  memory used does not depend on the length of the records.
+ *
+ *  feed() and finish() read the whole stream as one record. feedRecords() and
+ *  finishRecords() split it into records the same way FileScanner::forEachRecord() does and
+ *  report the recognized ones by their offsets in the stream. The two ways should not be mixed
+ *  in one stream.
+ *
+ */
+class StreamMatcher {
+public:
+    ///A record given by its offsets in bytes from the beginning of the stream (end is not included).
+    struct Record {
+        std::uint64_t start;
+        std::uint64_t end;
+    };
+
+private:
+    ///The automaton (copies share its table).
+    CompiledAutomaton automaton;
+
+    FileScanner::RecordMode mode;
+
+    ///The state after the bytes of the current record.
+    std::uint32_t current;
+
+    ///The state before the last byte of the current record, to drop a trailing '\r' of a line.
+    std::uint32_t beforeLast;
+
+    ///The last byte of the current record ('\0' if it is empty).
+    char lastLetter = '\0';
+
+    ///Number of bytes of the stream fed so far.
+    std::uint64_t offset = 0;
+
+    ///Offset of the first byte of the current record.
+    std::uint64_t recordStart = 0;
+
+    ///Whether the current word has started (only used for words).
+    bool inWord = false;
+
+    ///Reads the bytes of the current record.
+    void walk(const char*, const char*);
+
+    ///Starts a new record at the given offset.
+    void startRecord(std::uint64_t);
+
+    ///Calls the callback with the record that ends at the given offset if it is recognized.
+    template <typename Callback>
+    void endRecord(std::uint64_t, Callback&&);
+
+public:
+    explicit StreamMatcher(const CompiledAutomaton&, FileScanner::RecordMode = FileScanner::lines);
+
+    ///Reads the next part of the current record.
+    void feed(const char*, std::size_t);
+
+    ///Ends the current record. Returns whether the automaton recognizes it.
+    bool finish();
+
+    ///Checks if nothing that follows can make the current record recognized, so the rest of it can be skipped.
+    bool isDead() const;
+
+    /** Reads the next part of the stream and splits it into records.
+     *
+     *  Calls the callback with every recognized record that ends in this part. A record that
+     *  is not ended yet is continued by the next call.
+     *
+     */
+    template <typename Callback>
+    void feedRecords(const char*, std::size_t, Callback&&);
+
+    ///Ends the stream. Calls the callback with the last record if it is recognized and starts a new stream.
+    template <typename Callback>
+    void finishRecords(Callback&&);
+
+    ///Forgets everything fed so far and starts a new stream.
+    void reset();
+};
+
+template <typename Callback>
+void StreamMatcher::endRecord(std::uint64_t end, Callback&& callback) {
+    //Lines drop a trailing '\r', which is the last byte the automaton read.
+    std::uint32_t state = current;
+    if (mode == FileScanner::lines && end > recordStart && lastLetter == '\r') {
+        state = beforeLast;
+        end--;
+    }
+
+    if (automaton.isFinal(state)) callback(Record{recordStart, end});
+}
+
+template <typename Callback>
+void StreamMatcher::feedRecords(const char* data, std::size_t size, Callback&& callback) {
+    const char* position = data;
+    const char* end = data + size;
+    std::uint64_t chunkStart = offset;
+    offset += size;
+
+    if (mode == FileScanner::lines) {
+        while (position < end) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(position, '\n', end - position));
+            if (lineEnd == nullptr) {
+                walk(position, end);
+                break;
+            }
+
+            walk(position, lineEnd);
+            endRecord(chunkStart + (lineEnd - data), callback);
+            startRecord(chunkStart + (lineEnd - data) + 1);
+            position = lineEnd + 1;
+        }
+    }
+    else {
+        while (position < end) {
+            if (!inWord) {
+                while (position < end && FileScanner::isWhitespace(*position)) position++;
+                if (position == end) break;
+
+                startRecord(chunkStart + (position - data));
+                inWord = true;
+            }
+
+            const char* wordEnd = position;
+            while (wordEnd < end && !FileScanner::isWhitespace(*wordEnd)) wordEnd++;
+            walk(position, wordEnd);
+            if (wordEnd == end) break;
+
+            endRecord(chunkStart + (wordEnd - data), callback);
+            inWord = false;
+            position = wordEnd;
+        }
+    }
+}
+
+template <typename Callback>
+void StreamMatcher::finishRecords(Callback&& callback) {
+    //The empty record after the last '\n' is skipped, like in FileScanner.
+    bool pending = mode == FileScanner::lines ? offset > recordStart : inWord;
+    if (pending) endRecord(offset, callback);
+
+    reset();
+}
+
+#endif
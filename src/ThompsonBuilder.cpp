@@ -0,0 +1,104 @@
+#include "ThompsonBuilder.hpp"
+
+int ThompsonBuilder::addState() {
+    pool.emplace_back();
+    return pool.size() - 1;
+}
+
+void ThompsonBuilder::addTransition(int from, int to, char letter) {
+    pool[from].push_back({to, letter});
+}
+
+std::vector<int> ThompsonBuilder::reachableStates(int state) const {
+    std::vector<bool> visited(pool.size(), false);
+    std::vector<int> reachable(1, state);
+    visited[state] = true;
+
+    for (std::size_t i = 0; i < reachable.size(); i++) {
+        for (const PoolTransition& transition : pool[reachable[i]]) {
+            if (!visited[transition.to]) {
+                visited[transition.to] = true;
+                reachable.push_back(transition.to);
+            }
+        }
+    }
+
+    return reachable;
+}
+
+ThompsonBuilder::Fragment ThompsonBuilder::letter(char c) {
+    Fragment fragment = {addState(), addState()};
+    addTransition(fragment.beginning, fragment.final, c == '@' ? EPSILON : c);
+    return fragment;
+}
+
+ThompsonBuilder::Fragment ThompsonBuilder::concat(Fragment first, Fragment second) {
+    addTransition(first.final, second.beginning, EPSILON);
+    return {first.beginning, second.final};
+}
+
+ThompsonBuilder::Fragment ThompsonBuilder::un(Fragment first, Fragment second) {
+    Fragment fragment = {addState(), addState()};
+    addTransition(fragment.beginning, first.beginning, EPSILON);
+    addTransition(fragment.beginning, second.beginning, EPSILON);
+    addTransition(first.final, fragment.final, EPSILON);
+    addTransition(second.final, fragment.final, EPSILON);
+    return fragment;
+}
+
+ThompsonBuilder::Fragment ThompsonBuilder::iteration(Fragment inner) {
+    Fragment fragment = {addState(), addState()};
+    addTransition(fragment.beginning, inner.beginning, EPSILON);
+    addTransition(fragment.beginning, fragment.final, EPSILON);
+    addTransition(inner.final, inner.beginning, EPSILON);
+    addTransition(inner.final, fragment.final, EPSILON);
+    return fragment;
+}
+
+ThompsonBuilder::Fragment ThompsonBuilder::intersection(Fragment first, Fragment second) {
+    return add(Automaton::intersection(build(first), build(second)));
+}
+
+ThompsonBuilder::Fragment ThompsonBuilder::add(const Automaton& automaton) {
+    Fragment fragment = {addState(), addState()};
+
+    std::map<int, int> index;
+    for (int state : automaton.getStates()) {
+        index[state] = addState();
+    }
+
+    for (auto& transition : automaton.getTransitions()) {
+        for (char c : transition.second) {
+            addTransition(index.at(transition.first.first), index.at(transition.first.second), c);
+        }
+    }
+
+    for (int beginningState : automaton.getBeginningStates()) {
+        addTransition(fragment.beginning, index.at(beginningState), EPSILON);
+    }
+    for (int finalState : automaton.getFinalStates()) {
+        addTransition(index.at(finalState), fragment.final, EPSILON);
+    }
+
+    return fragment;
+}
+
+Automaton ThompsonBuilder::build(Fragment fragment) const {
+    std::vector<int> reachable = reachableStates(fragment.beginning);
+
+    std::vector<int> index(pool.size(), 0);
+    for (std::size_t i = 0; i < reachable.size(); i++) {
+        index[reachable[i]] = i + 1;
+    }
+
+    Automaton::Builder builder;
+    builder.reserve(reachable.size(), reachable.size() * 2);
+    for (int state : reachable) {
+        builder.addState(index[state], state == fragment.beginning, state == fragment.final);
+        for (const PoolTransition& transition : pool[state]) {
+            builder.addTransition(std::make_pair(index[state], index[transition.to]), transition.letter);
+        }
+    }
+
+    return builder.finalize();
+}
@@ -0,0 +1,66 @@
+#ifndef __THOMPSON_BUILDER_HPP_
+#define __THOMPSON_BUILDER_HPP_
+
+#include <vector>
+#include "Automaton.hpp"
+
+/** Builds an automaton from a regular expression with Thompson's construction.
+ *
+ *  All fragments live in one shared pool of states and transitions. Combining fragments only
+ *  appends a few states and epsilon transitions to the pool, nothing is copied, and the
+ *  automaton is created once at the end.
+ *
+ */
+class ThompsonBuilder {
+public:
+    ///Part of the automaton with one beginning and one final state.
+    struct Fragment {
+        int beginning;
+        int final;
+    };
+
+private:
+    ///Transition of the pool.
+    struct PoolTransition {
+        int to;
+        char letter;
+    };
+
+    ///Transitions of every state in the pool.
+    std::vector<std::vector<PoolTransition>> pool;
+
+    int addState();
+    void addTransition(int, int, char);
+
+    ///Gets the states of the pool reachable from the given state.
+    std::vector<int> reachableStates(int) const;
+
+public:
+    ///Fragment that reads a single letter ('@' or EPSILON for the empty word).
+    Fragment letter(char);
+
+    ///Fragment that reads the first fragment and then the second one.
+    Fragment concat(Fragment, Fragment);
+
+    ///Fragment that reads either of the fragments.
+    Fragment un(Fragment, Fragment);
+
+    ///Fragment that reads the fragment any number of times.
+    Fragment iteration(Fragment);
+
+    /** Fragment that reads what both fragments read.
+     *
+     *  There is no Thompson rule for it, so both fragments are taken out of the pool as
+     *  automatons, intersected with Automaton::intersection() and the result is added back.
+     *
+     */
+    Fragment intersection(Fragment, Fragment);
+
+    ///Adds a copy of the automaton to the pool.
+    Fragment add(const Automaton&);
+
+    ///Creates the automaton of the fragment, with states numbered from 1.
+    Automaton build(Fragment) const;
+};
+
+#endif
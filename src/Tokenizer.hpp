@@ -1,30 +1,93 @@
 #ifndef __TOKENIZER_HPP_
 #define __TOKENIZER_HPP_
 
-#include <iostream>
+#include <cstddef>
+#include <string_view>
 
+/** Splits a regular expression into tokens.
+ *
+ *  Works directly on the characters of the expression, the caller has to keep them alive for
+ *  as long as the tokenizer is used. Whitespace is skipped. Everything is constexpr, so the
+ *  same tokenizer also runs at compile time (see StaticRegex).
+ *
+ */
 class Tokenizer {
 private:
-    ///The input stream which the tokenizer manages.
-    std::istream& in;    
+    ///The regular expression which the tokenizer manages.
+    std::string_view input;
 
-    ///Clears the whitespaces from the stream.
-    void clearWhitespace();
+    ///Position of the next token.
+    std::size_t position = 0;
+
+    ///Skips the whitespace before the next token.
+    constexpr void clearWhitespace() {
+        while (position < input.size() && isWhitespace(input[position])) {
+            position++;
+        }
+    }
+
+    static constexpr bool isWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    }
 
 public:
     struct Token {
         enum Type {open_bracket, closing_bracket, oper, letter, error};
         Type type;
         char symbol;
+
+        ///Gets the priority of an operator, higher binds tighter.
+        constexpr int priority() const {
+            switch (symbol) {
+                case '*': return 3;
+                case '.': return 2;
+                case '&': 
+                case '+': return 1;
+                default: return 0;
+            }
+        }
     };
 
-    Tokenizer(std::istream&);
+    ///Checks if the character is whitespace, a bracket or an operator, which can never be a letter.
+    static constexpr bool isSyntax(char c) {
+        return isWhitespace(c) || c == '(' || c == ')' || c == '+' || c == '.' || c == '*' || c == '&';
+    }
+
+    explicit constexpr Tokenizer(std::string_view input) : input(input) {
+        clearWhitespace();
+    }
 
     ///Checks if the tokenizer has any tokens left to managing.
-    bool hasMore() const;
+    constexpr bool hasMore() const {
+        return position < input.size();
+    }
+
+    ///Gets the next token. Returns an error token if there are none left.
+    constexpr Token getToken() {
+        if (!hasMore()) return {Token::error, 0};
+
+        Token token = {Token::letter, input[position++]};
+
+        switch (token.symbol) {
+            case '(': 
+                token.type = Token::open_bracket;
+                break;
+            case ')': 
+                token.type = Token::closing_bracket;
+                break;
+            case '+':
+            case '.':
+            case '*':
+            case '&':
+                token.type = Token::oper;
+                break;
+            default:
+                break;
+        } 
 
-    ///Gets the next token.
-    Token getToken();
+        clearWhitespace();
+        return token;
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
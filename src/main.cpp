@@ -1,38 +1,192 @@
 #include <iostream>
-#include <fstream>
 
 #include "Automaton.hpp"
+#include "FileScanner.hpp"
+#include "LazyDfa.hpp"
+#include "PatternSet.hpp"
+#include "SearchAutomaton.hpp"
 
-/// Opens a text file and prints all rows which are recognized by the automaton.
-bool readFile (std::string& path, Automaton automaton) {
-    std::ifstream in (path, std::ios::in);
+/// Opens a text file and prints all records which are recognized by the automaton.
+template <typename Matcher>
+bool readFile (std::string& path, Matcher& automaton, FileScanner::RecordMode mode, std::string_view prefix = "") {
+    FileScanner scanner(path);
 
-    if (!in.is_open()) {
-        throw std::runtime_error("Invalid file path!");
+    FileScanner::forEachRecordWithPrefix(scanner.getContents(), mode, prefix, [&](std::string_view record) {
+        if (automaton.match(record)) {
+            std::cout.write(record.data(), record.size()) << '\n';
+        }
+    });
+
+    std::cout.flush();
+    return true;
+}
+
+/// Opens a text file and prints all records which are recognized by the automaton, matching them on several threads.
+bool readFileParallel (std::string& path, const CompiledAutomaton& automaton, FileScanner::RecordMode mode, std::size_t threads) {
+    FileScanner scanner(path);
+
+    for (std::string_view record : scanner.findMatches(mode, automaton, threads, automaton.getRequiredPrefix())) {
+        std::cout.write(record.data(), record.size()) << '\n';
     }
 
-    std::string word;
+    std::cout.flush();
+    return true;
+}
+
+/// Opens a text file and prints all records which are recognized by any of the patterns, after the ids of these patterns.
+bool readFilePatterns (std::string& path, const CompiledAutomaton& patterns, FileScanner::RecordMode mode) {
+    FileScanner scanner(path);
 
-    while (in.good()) {
-        in >> word;
-        if (automaton.recognize(word)) {
-            std::cout << word << std::endl;
+    FileScanner::forEachRecordWithPrefix(scanner.getContents(), mode, patterns.getRequiredPrefix(), [&](std::string_view record) {
+        CompiledAutomaton::PatternRange matched = patterns.matchPatterns(record);
+        if (matched.empty()) return;
+
+        const char* separator = "";
+        for (int id : matched) {
+            std::cout << separator << id;
+            separator = ",";
         }
+        std::cout << ' ';
+        std::cout.write(record.data(), record.size()) << '\n';
+    });
+
+    std::cout.flush();
+    return true;
+}
+
+/// Opens a file and prints every part of it which is recognized by the automaton, after its start and end offsets.
+bool searchFile (std::string& path, const SearchAutomaton& automaton) {
+    FileScanner scanner(path);
+    std::string_view contents = scanner.getContents();
+
+    for (SearchAutomaton::Match match : automaton.findAll(contents)) {
+        std::cout << match.start << ' ' << match.end << ' ';
+        std::cout.write(contents.data() + match.start, match.end - match.start) << '\n';
     }
 
-    in.close();
+    std::cout.flush();
+    return true;
+}
+
+/// Opens a text file and prints all records which are recognized by the automaton, matching them in batches.
+bool readFileBatched (std::string& path, const CompiledAutomaton& automaton, FileScanner::RecordMode mode) {
+    FileScanner scanner(path);
+
+    std::vector<std::string_view> batch;
+    std::vector<std::uint64_t> matched;
+    auto printMatches = [&]() {
+        matched.resize((batch.size() + 63) / 64);
+        automaton.matchBatch(batch.data(), batch.size(), matched.data());
+
+        for (std::size_t i = 0; i < batch.size(); i++) {
+            if ((matched[i / 64] >> (i % 64)) & 1) std::cout.write(batch[i].data(), batch[i].size()) << '\n';
+        }
+        batch.clear();
+    };
+
+    FileScanner::forEachRecordWithPrefix(scanner.getContents(), mode, automaton.getRequiredPrefix(), [&](std::string_view record) {
+        batch.push_back(record);
+        if (batch.size() == 4096) printMatches();
+    });
+    printMatches();
+
+    std::cout.flush();
     return true;
 }
 
+void readFileCompiled (std::string& path, const CompiledAutomaton& automaton, FileScanner::RecordMode mode, std::size_t threads) {
+    if (threads == 1) {
+        readFileBatched(path, automaton, mode);
+    }
+    else {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        readFileParallel(path, automaton, mode, threads);
+    }
+}
+
 int main (int argc, char** argv) {
+    std::ios::sync_with_stdio(false);
+
+    if (argc < 2) throw std::runtime_error("Missing file path!");
     std::string filePath = argv[1];
-    std::string regex = argv[2];
+
+    //The regex may be left out when the automaton is loaded with --load.
+    int firstOption = 2;
+    std::string regex;
+    if (argc > 2 && std::string(argv[2]).rfind("--", 0) != 0) {
+        regex = argv[2];
+        firstOption = 3;
+    }
+
+    bool lazy = false, minimized = false, search = false, complement = false;
+    std::size_t threads = 1;
+    FileScanner::RecordMode mode = FileScanner::words;
+    std::vector<std::string> extraPatterns;
+    std::string savePath, loadPath;
+    for (int i = firstOption; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--lazy") lazy = true;
+        else if (option == "--minimize") minimized = true;
+        else if (option == "--lines") mode = FileScanner::lines;
+        else if (option == "--search") search = true;
+        else if (option == "--complement") complement = true;
+        else if (option == "--threads" && i + 1 < argc) threads = std::stoul(argv[++i]);
+        else if (option == "--pattern" && i + 1 < argc) extraPatterns.push_back(argv[++i]);
+        else if (option == "--save" && i + 1 < argc) savePath = argv[++i];
+        else if (option == "--load" && i + 1 < argc) loadPath = argv[++i];
+        else throw std::runtime_error("Unknown option " + option + "!");
+    }
+
+    //A loaded automaton replaces the regex, nothing is parsed or determined.
+    if (!loadPath.empty()) {
+        if (lazy || search || complement || !extraPatterns.empty()) throw std::runtime_error("--load can not be combined with --lazy, --search, --complement or --pattern!");
+
+        //An automaton saved with --pattern reports the ids of the patterns like it did then.
+        CompiledAutomaton loaded = CompiledAutomaton::load(loadPath);
+        if (loaded.isPatternSet()) readFilePatterns(filePath, loaded, mode);
+        else readFileCompiled(filePath, loaded, mode, threads);
+        return 0;
+    }
+
+    if (firstOption == 2) throw std::runtime_error("Missing regex!");
 
     Automaton automaton;
     automaton << regex;
+    if (complement && (lazy || search || !extraPatterns.empty())) throw std::runtime_error("--complement can not be combined with --lazy, --search or --pattern!");
 
-    readFile(filePath, automaton);
+    //Searches the whole file instead of matching records.
+    if (search) {
+        if (lazy || !extraPatterns.empty() || !savePath.empty()) throw std::runtime_error("--search can not be combined with --lazy, --pattern or --save!");
+
+        searchFile(filePath, SearchAutomaton(automaton, minimized));
+        return 0;
+    }
+
+    PatternSet patterns;
+    patterns.add(automaton);
+    for (const std::string& pattern : extraPatterns) {
+        patterns.add(pattern);
+    }
+
+    if (patterns.size() > 1) {
+        CompiledAutomaton compiledPatterns = patterns.compile(minimized);
+        if (!savePath.empty()) compiledPatterns.save(savePath);
+
+        readFilePatterns(filePath, compiledPatterns, mode);
+    }
+    else if (lazy) {
+        if (threads != 1) throw std::runtime_error("The lazy automaton can not be shared between threads!");
+        if (!savePath.empty()) throw std::runtime_error("The lazy automaton can not be saved!");
+
+        LazyDfa lazyAutomaton(automaton);
+        readFile(filePath, lazyAutomaton, mode);
+    }
+    else {
+        CompiledAutomaton compiledAutomaton = complement ? automaton.compileComplement(minimized) : automaton.compile(minimized);
+        if (!savePath.empty()) compiledAutomaton.save(savePath);
+
+        readFileCompiled(filePath, compiledAutomaton, mode, threads);
+    }
 
     return 0;
 }
-
@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Automaton.hpp"
+#include "CompiledAutomaton.hpp"
+#include "LazyDfa.hpp"
+#include "PatternSet.hpp"
+#include "SearchAutomaton.hpp"
+#include "StaticRegex.hpp"
+#include "StreamMatcher.hpp"
+
+/** Checks every way of matching against a reference that does not use the library.
+ *
+ *  Usage: automaton_test [seed]
+ *
+ *  The reference parses the expression on its own and evaluates it on the words directly
+ *  (see Reference), so it does not share ThompsonBuilder, intersection or any automaton with
+ *  what it checks. Every random pattern is compared with it on random words through
+ *  recognize(), compile() with and without minimization, LazyDfa, matchBatch(),
+ *  StreamMatcher, save() and load(), compileComplement(), both complement() and the
+ *  expression read back from convertToRegex(). Its matches in random texts are compared
+ *  through SearchAutomaton, its records through StreamMatcher::feedRecords(), and groups of
+ *  patterns through PatternSet. A few fixed patterns are checked through StaticRegex. Every
+ *  mismatch is printed and the exit code is 1 if there was one.
+ *
+ */
+
+namespace {
+    std::size_t failures = 0;
+
+    ///Number of random patterns.
+    constexpr std::size_t PATTERN_COUNT = 600;
+
+    ///Number of random words every pattern is checked on.
+    constexpr std::size_t WORD_COUNT = 40;
+
+    void check(bool condition, const char* what, const std::string& regex, const std::string& word) {
+        if (condition) return;
+
+        failures++;
+        if (failures <= 20) std::printf("FAILED %s: regex \"%s\", word \"%s\"\n", what, regex.c_str(), word.c_str());
+    }
+
+    /** Reference semantics of a regular expression.
+     *
+     *  The expression is parsed by recursive descent with the priorities of the library ('*'
+     *  over '.' over '+' and '&') and every subexpression is evaluated to the set of spans
+     *  [i, j) of the text it matches. A word is recognized if the whole expression matches
+     *  [0, n), and the matches of a search are read off the same set. Cubic in the length of
+     *  the text, which is fine for the short texts of the test.
+     *
+     */
+    class Reference {
+    private:
+        struct Node {
+            char symbol;
+            int left;
+            int right;
+        };
+
+        std::vector<Node> nodes;
+        int root = -1;
+
+        std::string regex;
+        std::size_t position = 0;
+
+        int addNode(char symbol, int left = -1, int right = -1) {
+            nodes.push_back({symbol, left, right});
+            return nodes.size() - 1;
+        }
+
+        int parseUnion() {
+            int node = parseConcat();
+            while (position < regex.size() && (regex[position] == '+' || regex[position] == '&')) {
+                char symbol = regex[position++];
+                node = addNode(symbol, node, parseConcat());
+            }
+            return node;
+        }
+
+        int parseConcat() {
+            int node = parseStar();
+            while (position < regex.size() && regex[position] == '.') {
+                position++;
+                node = addNode('.', node, parseStar());
+            }
+            return node;
+        }
+
+        int parseStar() {
+            int node = parseAtom();
+            while (position < regex.size() && regex[position] == '*') {
+                position++;
+                node = addNode('*', node);
+            }
+            return node;
+        }
+
+        int parseAtom() {
+            if (regex[position] != '(') return addNode(regex[position++]);
+
+            position++;
+            int node = parseUnion();
+            position++;
+            return node;
+        }
+
+        ///Gets the spans of the text the node matches, [i, j) is spans[i * (n + 1) + j].
+        std::vector<bool> evaluate(int node, const std::string& text) const {
+            std::size_t n = text.size(), width = n + 1;
+            std::vector<bool> spans(width * width, false);
+            const Node& data = nodes[node];
+
+            switch (data.symbol) {
+                case '.':
+                case '+':
+                case '&': {
+                    std::vector<bool> left = evaluate(data.left, text), right = evaluate(data.right, text);
+                    for (std::size_t i = 0; i <= n; i++) {
+                        for (std::size_t j = i; j <= n; j++) {
+                            if (data.symbol == '+') spans[i * width + j] = left[i * width + j] || right[i * width + j];
+                            else if (data.symbol == '&') spans[i * width + j] = left[i * width + j] && right[i * width + j];
+                            else for (std::size_t k = i; k <= j && !spans[i * width + j]; k++) spans[i * width + j] = left[i * width + k] && right[k * width + j];
+                        }
+                    }
+                    break;
+                }
+                case '*': {
+                    //Empty iterations change nothing, so every other one reads at least one letter.
+                    std::vector<bool> inner = evaluate(data.left, text);
+                    for (std::size_t i = 0; i <= n; i++) {
+                        spans[i * width + i] = true;
+                        for (std::size_t j = i + 1; j <= n; j++) {
+                            for (std::size_t k = i; k < j && !spans[i * width + j]; k++) spans[i * width + j] = spans[i * width + k] && inner[k * width + j];
+                        }
+                    }
+                    break;
+                }
+                case '@':
+                    for (std::size_t i = 0; i <= n; i++) spans[i * width + i] = true;
+                    break;
+                default:
+                    for (std::size_t i = 0; i < n; i++) spans[i * width + i + 1] = data.symbol == '?' || text[i] == data.symbol;
+                    break;
+            }
+
+            return spans;
+        }
+
+    public:
+        explicit Reference(const std::string& regex) : regex(regex) {
+            if (!regex.empty()) root = parseUnion();
+        }
+
+        bool recognizes(const std::string& word) const {
+            return root >= 0 && evaluate(root, word)[word.size()];
+        }
+
+        ///The leftmost-longest matches of at least one byte that do not overlap.
+        std::vector<SearchAutomaton::Match> findAll(const std::string& text) const {
+            std::vector<SearchAutomaton::Match> matches;
+            if (root < 0) return matches;
+
+            std::size_t width = text.size() + 1;
+            std::vector<bool> spans = evaluate(root, text);
+            std::size_t start = 0;
+            while (start < text.size()) {
+                std::size_t end = start;
+                for (std::size_t j = start + 1; j <= text.size(); j++) {
+                    if (spans[start * width + j]) end = j;
+                }
+                if (end == start) {
+                    start++;
+                    continue;
+                }
+
+                matches.push_back({start, end});
+                start = end;
+            }
+            return matches;
+        }
+    };
+
+    ///Random regular expression over a, b and c with '?', epsilon, and intersection if allowed.
+    std::string randomRegex(std::mt19937& generator, int depth, bool intersection) {
+        static const char letters[] = {'a', 'b', 'c', '?', '@'};
+
+        int kind = generator() % (depth <= 0 ? 2 : (intersection ? 6 : 5));
+        switch (kind) {
+            case 0:
+            case 1:
+                return std::string(1, letters[generator() % 5]);
+            case 2:
+                return "(" + randomRegex(generator, depth - 1, intersection) + "." + randomRegex(generator, depth - 1, intersection) + ")";
+            case 3:
+                return "(" + randomRegex(generator, depth - 1, intersection) + "+" + randomRegex(generator, depth - 1, intersection) + ")";
+            case 4:
+                return "(" + randomRegex(generator, depth - 1, intersection) + ")*";
+            default:
+                return "(" + randomRegex(generator, depth - 1, intersection) + "&" + randomRegex(generator, depth - 1, intersection) + ")";
+        }
+    }
+
+    ///Random word over a to d, with a literal '?' and the epsilon byte now and then.
+    std::string randomWord(std::mt19937& generator, std::size_t maxLength) {
+        static const char letters[] = {'a', 'b', 'c', 'd', 'a', 'b', 'c', 'd', '?', EPSILON};
+
+        std::string word(generator() % (maxLength + 1), 'a');
+        for (char& c : word) {
+            c = letters[generator() % 10];
+        }
+        return word;
+    }
+
+    ///States that only setTransitions() names are states of the automaton as well.
+    void testSetTransitions() {
+        const std::string name = "setTransitions({{1, 2}, {'a'}}, {{2, 3}, {'b'}})";
+
+        Automaton automaton;
+        automaton.setTransitions({{{1, 2}, {'a'}}, {{2, 3}, {'b'}}});
+        automaton.addBeginningState(1);
+        check(automaton.getStates().size() == 3, "setTransitions() states", name, "");
+        check(!automaton.recognize("ab"), "recognize without final states", name, "ab");
+
+        automaton.addFinalState(3);
+        check(automaton.recognize("ab"), "recognize", name, "ab");
+        check(!automaton.recognize("a"), "recognize", name, "a");
+        check(!automaton.recognize("abbb"), "recognize", name, "abbb");
+        check(automaton.compile().match("ab") && !automaton.compile().match("abbb"), "compile().match", name, "ab");
+
+        Automaton converted;
+        converted.readRegex(automaton.convertToRegex());
+        check(converted.recognize("ab") && !converted.recognize("abbb"), "convertToRegex()", name, "ab");
+    }
+
+    ///complement() and the expression convertToRegex() writes for it agree with the reference, also on the bytes of the regex syntax.
+    void testComplementRegex(std::mt19937& generator, const std::string& regex) {
+        static const char letters[] = {'a', 'b', 'c', 'd', '(', '+', ' ', '@'};
+
+        Reference reference(regex);
+        Automaton automaton;
+        automaton.readRegex(regex);
+        Automaton complement = Automaton::complement(automaton);
+        Automaton converted;
+        converted.readRegex(complement.convertToRegex());
+
+        for (std::size_t i = 0; i < WORD_COUNT; i++) {
+            std::string word(generator() % 7, 'a');
+            for (char& c : word) {
+                c = letters[generator() % 8];
+            }
+
+            //The default alphabet leaves out the bytes of the regex syntax.
+            bool expected = word.find_first_of("(+ @") == std::string::npos && !reference.recognizes(word);
+            check(complement.recognize(word) == expected, "complement().recognize", regex, word);
+            check(converted.recognize(word) == expected, "complement().convertToRegex()", regex, word);
+        }
+    }
+
+    void testPattern(std::mt19937& generator, const std::string& regex, const std::filesystem::path& file) {
+        Reference reference(regex);
+        Automaton automaton;
+        automaton.readRegex(regex);
+
+        CompiledAutomaton compiled = automaton.compile();
+        CompiledAutomaton minimized = automaton.compile(true);
+        CompiledAutomaton complement = automaton.compileComplement();
+        Automaton complementAutomaton = Automaton::complement(automaton);
+        Automaton complementAb = Automaton::complement(automaton, {'a', 'b'});
+        Automaton converted;
+        converted.readRegex(automaton.convertToRegex());
+        LazyDfa lazy(automaton, 4);
+        StreamMatcher stream(compiled);
+
+        compiled.save(file.string());
+        CompiledAutomaton loaded = CompiledAutomaton::load(file.string());
+
+        std::vector<std::string> words;
+        std::vector<bool> expected;
+        for (std::size_t i = 0; i < WORD_COUNT; i++) {
+            words.push_back(randomWord(generator, 12));
+            expected.push_back(reference.recognizes(words.back()));
+        }
+
+        for (std::size_t i = 0; i < words.size(); i++) {
+            const std::string& word = words[i];
+
+            check(automaton.recognize(word) == expected[i], "recognize", regex, word);
+            check(compiled.match(word) == expected[i], "compile().match", regex, word);
+            check(minimized.match(word) == expected[i], "compile(true).match", regex, word);
+            check(lazy.match(word) == expected[i], "LazyDfa::match", regex, word);
+            check(loaded.match(word) == expected[i], "load().match", regex, word);
+            check(converted.recognize(word) == expected[i], "convertToRegex()", regex, word);
+            check(complement.match(word) != expected[i], "compileComplement().match", regex, word);
+
+            //complement() does not read '?' and the epsilon byte, they can not be its letters.
+            if (word.find_first_of(std::string{'?', EPSILON}) == std::string::npos) {
+                check(complementAutomaton.recognize(word) != expected[i], "complement().recognize", regex, word);
+            }
+            bool overAb = word.find_first_not_of("ab") == std::string::npos;
+            check(complementAb.recognize(word) == (overAb && !expected[i]), "complement(a, {a, b}).recognize", regex, word);
+
+            //The word is fed in random chunks.
+            std::size_t position = 0;
+            while (position < word.size()) {
+                std::size_t size = std::min<std::size_t>(1 + generator() % 4, word.size() - position);
+                stream.feed(word.data() + position, size);
+                position += size;
+            }
+            check(stream.finish() == expected[i], "StreamMatcher::finish", regex, word);
+        }
+
+        std::vector<std::string_view> views(words.begin(), words.end());
+        std::vector<std::uint64_t> bits = compiled.matchBatch(views);
+        for (std::size_t i = 0; i < words.size(); i++) {
+            bool matched = (bits[i / 64] >> (i % 64)) & 1;
+            check(matched == expected[i], "matchBatch", regex, words[i]);
+        }
+    }
+
+    ///SearchAutomaton finds the leftmost-longest matches of the reference in random texts.
+    void testSearch(std::mt19937& generator, const std::string& regex) {
+        Reference reference(regex);
+        Automaton automaton;
+        automaton.readRegex(regex);
+        SearchAutomaton search(automaton, generator() % 2 == 0);
+
+        for (std::size_t i = 0; i < 4; i++) {
+            std::string text = randomWord(generator, 40);
+            std::vector<SearchAutomaton::Match> expected = reference.findAll(text), found = search.findAll(text);
+
+            bool same = expected.size() == found.size();
+            for (std::size_t j = 0; same && j < found.size(); j++) {
+                same = expected[j].start == found[j].start && expected[j].end == found[j].end;
+            }
+            check(same, "SearchAutomaton::findAll", regex, text);
+            check(search.contains(text) == !expected.empty(), "SearchAutomaton::contains", regex, text);
+        }
+    }
+
+    ///feedRecords() reports the records the reference recognizes, split the way FileScanner splits them.
+    void testRecords(std::mt19937& generator, const std::string& regex, FileScanner::RecordMode mode) {
+        static const char letters[] = {'a', 'b', 'c', '?', 'a', 'b', '\n', '\r', ' ', '\t'};
+
+        Reference reference(regex);
+        Automaton automaton;
+        automaton.readRegex(regex);
+        StreamMatcher stream(automaton.compile(), mode);
+
+        std::string text(generator() % 60, 'a');
+        for (char& c : text) {
+            c = letters[generator() % 10];
+        }
+
+        //Lines end at '\n' and drop a trailing '\r', the empty line after the last '\n' is no record.
+        //Words are the runs of bytes that are not whitespace.
+        std::vector<StreamMatcher::Record> expected;
+        for (std::size_t start = 0; start < text.size();) {
+            std::size_t end = start;
+            if (mode == FileScanner::lines) {
+                while (end < text.size() && text[end] != '\n') end++;
+            }
+            else {
+                if (FileScanner::isWhitespace(text[start])) {
+                    start++;
+                    continue;
+                }
+                while (end < text.size() && !FileScanner::isWhitespace(text[end])) end++;
+            }
+
+            std::size_t recordEnd = mode == FileScanner::lines && end > start && text[end - 1] == '\r' ? end - 1 : end;
+            if (reference.recognizes(text.substr(start, recordEnd - start))) expected.push_back({start, recordEnd});
+            start = end + (mode == FileScanner::lines);
+        }
+
+        std::vector<StreamMatcher::Record> found;
+        auto collect = [&](StreamMatcher::Record record) {
+            found.push_back(record);
+        };
+        std::size_t position = 0;
+        while (position < text.size()) {
+            std::size_t size = std::min<std::size_t>(1 + generator() % 8, text.size() - position);
+            stream.feedRecords(text.data() + position, size, collect);
+            position += size;
+        }
+        stream.finishRecords(collect);
+
+        bool same = expected.size() == found.size();
+        for (std::size_t i = 0; same && i < found.size(); i++) {
+            same = expected[i].start == found[i].start && expected[i].end == found[i].end;
+        }
+        check(same, mode == FileScanner::lines ? "feedRecords(lines)" : "feedRecords(words)", regex, text);
+    }
+
+    ///matchPatterns() reports every pattern of the set the reference recognizes, also after save() and load().
+    void testPatternSet(std::mt19937& generator, const std::vector<std::string>& regexes, const std::filesystem::path& file) {
+        PatternSet patterns;
+        std::vector<Reference> references;
+        std::string name;
+        for (const std::string& regex : regexes) {
+            patterns.add(regex);
+            references.emplace_back(regex);
+            name += (name.empty() ? "" : ", ") + regex;
+        }
+
+        CompiledAutomaton compiled = patterns.compile(generator() % 2 == 0);
+        compiled.save(file.string());
+        CompiledAutomaton loaded = CompiledAutomaton::load(file.string());
+        check(compiled.isPatternSet() && loaded.isPatternSet(), "PatternSet::compile().isPatternSet", name, "");
+
+        for (std::size_t i = 0; i < WORD_COUNT; i++) {
+            std::string word = randomWord(generator, 12);
+
+            std::vector<int> expected;
+            for (std::size_t id = 0; id < references.size(); id++) {
+                if (references[id].recognizes(word)) expected.push_back(id);
+            }
+
+            CompiledAutomaton::PatternRange matched = compiled.matchPatterns(word), matchedLoaded = loaded.matchPatterns(word);
+            check(std::vector<int>(matched.begin(), matched.end()) == expected, "PatternSet::matchPatterns", name, word);
+            check(std::vector<int>(matchedLoaded.begin(), matchedLoaded.end()) == expected, "load().matchPatterns", name, word);
+        }
+    }
+
+    template <typename StaticPattern>
+    void testStaticPattern(std::mt19937& generator, const StaticPattern& pattern, const std::string& regex) {
+        Reference reference(regex);
+        for (std::size_t i = 0; i < WORD_COUNT * 10; i++) {
+            std::string word = randomWord(generator, 12);
+            check(pattern.match(word) == reference.recognizes(word), "StaticRegex::compile().match", regex, word);
+        }
+    }
+
+    ///StaticRegex agrees with the reference, the patterns have to be literals.
+    void testStaticRegex(std::mt19937& generator) {
+        static constexpr auto first = StaticRegex::compile("(a+b)*.c");
+        static constexpr auto second = StaticRegex::compile("a.?*.b + (c.@)*");
+        static constexpr auto third = StaticRegex::compile("((a+@).(b)*)*.(c+?)");
+        static constexpr auto fourth = StaticRegex::compile("(?.?)*.(a.b+b.a)");
+        testStaticPattern(generator, first, "(a+b)*.c");
+        testStaticPattern(generator, second, "a.?*.b+(c.@)*");
+        testStaticPattern(generator, third, "((a+@).(b)*)*.(c+?)");
+        testStaticPattern(generator, fourth, "(?.?)*.(a.b+b.a)");
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned seed = argc > 1 ? std::stoul(argv[1]) : 1;
+    std::mt19937 generator(seed);
+    std::filesystem::path file = std::filesystem::temp_directory_path() / ("automaton_test_" + std::to_string(seed) + ".bin");
+
+    testSetTransitions();
+    testComplementRegex(generator, "a.b");
+    testStaticRegex(generator);
+
+    std::vector<std::string> regexes;
+    for (std::size_t i = 0; i < PATTERN_COUNT; i++) {
+        regexes.push_back(randomRegex(generator, 4, i % 3 == 0));
+        const std::string& regex = regexes.back();
+
+        testPattern(generator, regex, file);
+        testSearch(generator, regex);
+        testRecords(generator, regex, i % 2 == 0 ? FileScanner::lines : FileScanner::words);
+        if (i % 10 == 0) testComplementRegex(generator, regex);
+        if (i % 3 == 2) testPatternSet(generator, {regexes.end() - 3, regexes.end()}, file);
+    }
+    std::filesystem::remove(file);
+
+    std::printf("%zu patterns, %zu failures\n", PATTERN_COUNT, failures);
+    return failures == 0 ? 0 : 1;
+}